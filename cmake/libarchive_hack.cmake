@@ -25,6 +25,7 @@ set_target_properties(
 set_property(
     TARGET zlibstatic
     APPEND PROPERTY INTERFACE_INCLUDE_DIRECTORIES
+    "${CMAKE_CURRENT_SOURCE_DIR}/libs/zlib"
     "${CMAKE_CURRENT_BINARY_DIR}/zlib_build"
 )
 
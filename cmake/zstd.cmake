@@ -0,0 +1,19 @@
+# Builds zstd from source as a static target, the same way we do zlib
+
+# zstd keeps it's cmake project in a subfolder, and defaults to building everything
+set(ZSTD_BUILD_PROGRAMS OFF CACHE BOOL "")
+set(ZSTD_BUILD_CONTRIB OFF CACHE BOOL "")
+set(ZSTD_BUILD_TESTS OFF CACHE BOOL "")
+set(ZSTD_BUILD_SHARED OFF CACHE BOOL "")
+set(ZSTD_BUILD_STATIC ON CACHE BOOL "")
+set(ZSTD_LEGACY_SUPPORT OFF CACHE BOOL "")
+set(ZSTD_MULTITHREAD_SUPPORT OFF CACHE BOOL "")
+
+add_subdirectory(libs/zstd/build/cmake "${CMAKE_CURRENT_BINARY_DIR}/zstd_build" EXCLUDE_FROM_ALL)
+
+# Older versions don't export their include dir, so add it ourselves
+set_property(
+    TARGET libzstd_static
+    APPEND PROPERTY INTERFACE_INCLUDE_DIRECTORIES
+    "${CMAKE_CURRENT_SOURCE_DIR}/libs/zstd/lib"
+)
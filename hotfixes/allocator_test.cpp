@@ -0,0 +1,57 @@
+#include "pch.h"
+
+#include "hotfixes/hooks.h"
+#include "test_utils.h"
+
+using namespace dhf;
+using namespace dhf::hotfixes;
+
+namespace {
+
+const constexpr size_t TEST_SIZE = 64;
+
+/**
+ * @brief Checks if every byte in a buffer has the same value.
+ *
+ * @param data The buffer.
+ * @param len The length of the buffer.
+ * @param value The expected value.
+ * @return True if every byte matches.
+ */
+bool all_bytes_equal(const uint8_t* data, size_t len, uint8_t value) {
+    return std::all_of(data, data + len, [value](uint8_t byte) { return byte == value; });
+}
+
+}  // namespace
+
+int main(void) {
+    set_allocator(test::COUNTING_ALLOCATOR);
+
+    auto* zeroed = u_malloc<uint8_t>(TEST_SIZE);
+    test::check(all_bytes_equal(zeroed, TEST_SIZE, 0), "u_malloc zeros memory by default");
+    auto* unzeroed = u_malloc<uint8_t>(TEST_SIZE, false);
+    test::check(all_bytes_equal(unzeroed, TEST_SIZE, test::GARBAGE_BYTE),
+                "u_malloc leaves memory alone when not zeroing");
+    test::check(test::live_allocations == 2, "u_malloc uses the swapped in allocator");
+
+    memset(zeroed, 'A', TEST_SIZE);
+    zeroed = u_realloc<uint8_t>(zeroed, TEST_SIZE * 2);
+    test::check(all_bytes_equal(zeroed, TEST_SIZE, 'A'), "u_realloc keeps the original contents");
+    test::check(test::live_allocations == 2, "u_realloc uses the swapped in allocator");
+
+    u_free(zeroed);
+    u_free(unzeroed);
+    test::check(test::live_allocations == 0, "u_free uses the swapped in allocator");
+
+    test::fail_next_allocation = true;
+    bool threw = false;
+    try {
+        (void)u_malloc(TEST_SIZE);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    test::check(threw, "u_malloc throws when the allocator fails");
+
+    set_allocator(get_stand_in_allocator());
+    return test::exit_code();
+}
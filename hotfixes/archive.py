@@ -1,17 +1,63 @@
 #!/usr/bin/env python3
 # ruff: noqa: D102, D103
 import argparse
+import difflib
 import io
 import json
+import os
 import re
 import struct
 import tarfile
+import zlib
 from dataclasses import dataclass, field
-from datetime import datetime
+from datetime import UTC, datetime
 from pathlib import Path
+from typing import BinaryIO
+
+try:
+    import zstandard
+except ImportError:
+    zstandard = None
+
+TOC_NAME = ".toc"
+TOC_MAGIC = b"DHFT"
+TOC_VERSION = 1
+
+V2_MAGIC = b"DHF2"
+V2_HEADER_SIZE = 8
+V2_INDEX_ENTRY_FORMAT = "<QQQIB"
+V2_FOOTER_FORMAT = "<QI4s"
+V2_FOOTER_SEARCH_CHUNK_SIZE = 0x10000
+V2_VERSION = 2
+V2_POOLED_VERSION = 3
+V2_TIMELINE_VERSION = 4
+V2_COLUMNAR_VERSION = 5
+V2_NO_BASE = 0xFFFFFFFF
+
+DELTA_COPY = 0
+DELTA_SKIP = 1
+DELTA_INSERT = 2
+V2_CODEC_NONE = 0
+V2_CODEC_ZLIB = 1
+V2_CODEC_ZSTD = 2
+
+V2_CODECS = {"zlib": V2_CODEC_ZLIB, "zstd": V2_CODEC_ZSTD}
+
+CATALOG_MAGIC = b"DHFM"
+CATALOG_ENTRY_FORMAT = "<QqI"
+CATALOG_UNKNOWN_TIME = 0
+ZSTD_LEVEL = 19
+
+RE_NUMBERED_KEY = re.compile(r"(.*?)(0|[1-9][0-9]*)", re.DOTALL)
+MAX_KEY_NUMBER = 0xFFFFFFFF
+MAX_KEY_PREFIXES = 16
+VARINT_BITS = 7
+VARINT_VALUE_MASK = 0x7F
+VARINT_CONTINUE = 0x80
 
 RE_ARCHIVE_EVENT = re.compile(r"_-(?!(_\d\d){3})_(.+?)\.json")
 RE_ARCHIVE_TIME_ONLY = re.compile(r"(\d{4}(_\d\d){2}(_-(_\d\d){3})?).json")
+RE_ARCHIVE_TIMESTAMP = re.compile(r"\d{4}(_\d\d){2}_-(_\d\d){3}")
 
 name_overrides: dict[str, str] = {}
 
@@ -37,35 +83,215 @@ def get_friendly_name(path: Path) -> str:
     return path.stem
 
 
+def get_release_time(path: Path) -> int:
+    """
+    Gets when a point-in-time file was released, based on it's name.
+
+    Args:
+        path: The path to the file.
+    Returns:
+        The release time, as a unix timestamp, or CATALOG_UNKNOWN_TIME if it doesn't have one.
+    """
+    match = RE_ARCHIVE_TIMESTAMP.search(path.name)
+    if match is None:
+        return CATALOG_UNKNOWN_TIME
+    time = datetime.strptime(match.group(0), r"%Y_%m_%d_-_%H_%M_%S").replace(tzinfo=UTC)
+    return int(time.timestamp())
+
+
+def hash_hotfixes(hotfixes: list[tuple[str, str]]) -> tuple[int, int]:
+    """
+    Hashes a set of hotfixes the same way the dll does once the game's received them.
+
+    Args:
+        hotfixes: The hotfixes to hash.
+    Returns:
+        A tuple of the combined length of every key and value in utf16 chars, and the crc32 of them
+        all, each as utf16 including a null terminator.
+    """
+    encoded = b"".join(
+        string.encode("utf-16le", "surrogatepass") + b"\0\0"
+        for hotfix in hotfixes
+        for string in hotfix
+    )
+    num_chars = len(encoded) // 2 - 2 * len(hotfixes)
+    return num_chars, zlib.crc32(encoded)
+
+
 @dataclass
 class HotfixInfo:
     path: Path
     friendly_name: str = field(init=False)
+    release_time: int = field(init=False)
 
     def __post_init__(self) -> None:
         self.friendly_name = get_friendly_name(self.path)
+        self.release_time = get_release_time(self.path)
 
-    def compress(self) -> io.BytesIO:
-        binary = io.BytesIO()
+    num_hotfixes: int = field(init=False, default=0)
+    num_chars: int = field(init=False, default=0)
+    content_hash: int | None = field(init=False, default=None)
 
+    def load(self) -> list[tuple[str, str]]:
         with self.path.open() as file:
             params = json.load(file)["parameters"]
-
-            binary.write(struct.pack("<I", len(params)))
-
-            for hf in params:
-                # Explicitly saying le removes the BOM
-                key_bites = hf["key"].encode("utf-16le")
-                value_bites = hf["value"].encode("utf-16le")
-
-                binary.write(
-                    struct.pack("<I", len(key_bites) // 2)
-                    + key_bites
-                    + struct.pack("<I", len(value_bites) // 2)
-                    + value_bites,
-                )
-
-        return binary
+        hotfixes = [(hf["key"], hf["value"]) for hf in params]
+        self.num_hotfixes = len(hotfixes)
+        # The file won't have changed if we're loading it again, no need to hash it twice
+        if self.content_hash is None:
+            self.num_chars, self.content_hash = hash_hotfixes(hotfixes)
+        return hotfixes
+
+    def encode(self) -> bytes:
+        return encode_rows(self.load())
+
+    def catalog_entry(self) -> bytes:
+        assert self.content_hash is not None, "hotfixes must be loaded before they're catalogued"
+        return struct.pack(
+            CATALOG_ENTRY_FORMAT,
+            self.num_chars,
+            self.release_time,
+            self.content_hash,
+        )
+
+
+def encode_str(value: str) -> bytes:
+    # Explicitly saying le removes the BOM
+    bites = value.encode("utf-16le")
+    return struct.pack("<I", len(bites) // 2) + bites
+
+
+def encode_rows(hotfixes: list[tuple[str, str]]) -> bytes:
+    """
+    Encodes a set of hotfixes in the base layout, with each key and value one after the other.
+
+    Args:
+        hotfixes: The hotfixes to encode.
+    Returns:
+        The encoded set.
+    """
+    binary = io.BytesIO()
+    binary.write(struct.pack("<I", len(hotfixes)))
+    for key, value in hotfixes:
+        binary.write(encode_str(key) + encode_str(value))
+    return binary.getvalue()
+
+
+def encode_varint(value: int) -> bytes:
+    out = bytearray()
+    while value > VARINT_VALUE_MASK:
+        out.append((value & VARINT_VALUE_MASK) | VARINT_CONTINUE)
+        value >>= VARINT_BITS
+    out.append(value)
+    return bytes(out)
+
+
+def encode_utf8(value: str) -> bytes:
+    # Hotfixes may contain lone surrogates, which still need to make it through
+    return value.encode("utf8", "surrogatepass")
+
+
+def get_key_prefixes(hotfixes: list[tuple[str, str]]) -> list[str]:
+    """
+    Picks which prefixes numbered keys should be encoded against, e.g. `SparkPatchEntry`.
+
+    Args:
+        hotfixes: The hotfixes to look at.
+    Returns:
+        The most common prefixes, most common first.
+    """
+    counts: dict[str, int] = {}
+    for key, _ in hotfixes:
+        match = RE_NUMBERED_KEY.fullmatch(key)
+        if match and int(match.group(2)) <= MAX_KEY_NUMBER:
+            counts[match.group(1)] = counts.get(match.group(1), 0) + 1
+    return sorted(counts, key=lambda prefix: counts[prefix], reverse=True)[:MAX_KEY_PREFIXES]
+
+
+def encode_columnar(hotfixes: list[tuple[str, str]]) -> bytes:
+    """
+    Encodes a set of hotfixes in the columnar layout.
+
+    Args:
+        hotfixes: The hotfixes to encode.
+    Returns:
+        The encoded set.
+    """
+    prefixes = get_key_prefixes(hotfixes)
+    prefix_ids = {prefix: idx for idx, prefix in enumerate(prefixes)}
+
+    prefix_column = bytearray()
+    for prefix in prefixes:
+        encoded_prefix = encode_utf8(prefix)
+        prefix_column += encode_varint(len(encoded_prefix)) + encoded_prefix
+
+    keys = bytearray()
+    shared_lens = bytearray()
+    suffix_lens = bytearray()
+    suffixes = bytearray()
+    total_size = 0
+
+    last_number = 0
+    last_value = b""
+    for key, value in hotfixes:
+        encoded_key = encode_utf8(key)
+        encoded_value = encode_utf8(value)
+        total_size += len(encoded_key) + len(encoded_value)
+
+        match = RE_NUMBERED_KEY.fullmatch(key)
+        if match and match.group(1) in prefix_ids and int(match.group(2)) <= MAX_KEY_NUMBER:
+            number = int(match.group(2))
+            delta = number - last_number - 1
+            zigzag = delta * 2 if delta >= 0 else (-delta * 2) - 1
+            keys += encode_varint((zigzag * len(prefixes)) + prefix_ids[match.group(1)] + 1)
+            last_number = number
+        else:
+            keys += encode_varint(0) + encode_varint(len(encoded_key)) + encoded_key
+
+        shared = 0
+        max_shared = min(len(last_value), len(encoded_value))
+        while shared < max_shared and last_value[shared] == encoded_value[shared]:
+            shared += 1
+        shared_lens += encode_varint(shared)
+        suffix_lens += encode_varint(len(encoded_value) - shared)
+        suffixes += encoded_value[shared:]
+        last_value = encoded_value
+
+    out = io.BytesIO()
+    out.write(struct.pack("<II", len(hotfixes), total_size))
+    for column in (prefix_column, keys, shared_lens, suffix_lens, suffixes):
+        out.write(struct.pack("<I", len(column)) + column)
+    return out.getvalue()
+
+
+def encode_catalog(entries: list[bytes]) -> bytes:
+    """
+    Encodes the catalog, which follows the entries in the toc or index.
+
+    Args:
+        entries: The catalog entry of each set, in the same order as the toc or index entries.
+    Returns:
+        The encoded catalog.
+    """
+    header = CATALOG_MAGIC + struct.pack("<I", struct.calcsize(CATALOG_ENTRY_FORMAT))
+    return header + b"".join(entries)
+
+
+def compress_block(data: bytes, codec: int) -> bytes:
+    """
+    Compresses a block of data for a v2 archive.
+
+    Args:
+        data: The data to compress.
+        codec: The codec to compress with.
+    Returns:
+        The compressed data.
+    """
+    if codec == V2_CODEC_ZSTD:
+        if zstandard is None:
+            raise RuntimeError("Writing zstd archives requires the 'zstandard' package")
+        return zstandard.ZstdCompressor(level=ZSTD_LEVEL).compress(data)
+    return zlib.compress(data, level=9)
 
 
 def get_ordered_mods(mod_paths: list[Path]) -> list[HotfixInfo]:
@@ -91,6 +317,408 @@ def get_ordered_hotfixes(point_in_time: Path, filter_path: Path | None) -> list[
     )
 
 
+def create_toc(
+    tar: tarfile.TarFile,
+    entries: list[tuple[tarfile.TarInfo, int]],
+    catalog: bytes,
+) -> io.BytesIO:
+    """
+    Creates the table of contents member, which must be written first in the archive.
+
+    Args:
+        tar: The tar file the toc will be written to.
+        entries: The tar info and hotfix count of every other member, in write order.
+        catalog: The encoded catalog, to write after the entries.
+    Returns:
+        The toc data.
+    """
+
+    def header_size(info: tarfile.TarInfo) -> int:
+        return len(info.tobuf(tar.format, tar.encoding, tar.errors))  # type: ignore
+
+    def padded_size(size: int) -> int:
+        return -(-size // tarfile.BLOCKSIZE) * tarfile.BLOCKSIZE
+
+    names = [info.name.encode("utf8") for info, _ in entries]
+    toc_size = 12 + sum(4 + len(name) + 28 for name in names) + len(catalog)
+
+    toc_info = tarfile.TarInfo(TOC_NAME)
+    toc_info.size = toc_size
+
+    toc = io.BytesIO()
+    toc.write(TOC_MAGIC + struct.pack("<II", TOC_VERSION, len(entries)))
+
+    offset = header_size(toc_info) + padded_size(toc_size)
+    for name, (info, num_hotfixes) in zip(names, entries, strict=True):
+        data_offset = offset + header_size(info)
+        toc.write(struct.pack("<I", len(name)) + name)
+        toc.write(struct.pack("<QQQI", offset, data_offset, info.size, num_hotfixes))
+        offset = data_offset + padded_size(info.size)
+    toc.write(catalog)
+
+    assert toc.tell() == toc_size
+    return toc
+
+
+def write_tar(output: Path, all_hotfixes: list[HotfixInfo]) -> None:
+    """
+    Writes a legacy `.tar.gz` archive.
+
+    Args:
+        output: The path to write to.
+        all_hotfixes: The hotfixes to include.
+    """
+    with tarfile.open(output, "w:gz") as tar:
+        # The toc needs every size before anything else is written, so encode everything up front
+        all_data = [hf.encode() for hf in all_hotfixes]
+        all_infos: list[tuple[tarfile.TarInfo, int]] = []
+        for idx, (hf, data) in enumerate(zip(all_hotfixes, all_data, strict=True)):
+            info = tar.gettarinfo(hf.path, arcname=f"{idx:03};{hf.friendly_name}")
+            info.size = len(data)
+            all_infos.append((info, hf.num_hotfixes))
+
+        catalog = encode_catalog([hf.catalog_entry() for hf in all_hotfixes])
+        toc = create_toc(tar, all_infos, catalog)
+        toc_info = tarfile.TarInfo(TOC_NAME)
+        toc_info.size = toc.tell()
+        toc.seek(0)
+        tar.addfile(toc_info, toc)
+
+        for data, (info, _) in zip(all_data, all_infos, strict=True):
+            tar.addfile(info, io.BytesIO(data))
+
+
+@dataclass
+class V2Set:
+    """A set which has been written into a v2 archive."""
+
+    friendly_name: str
+    release_time: int
+    index_entry: bytes
+    catalog_entry: bytes
+
+
+def sync(file: BinaryIO) -> None:
+    file.flush()
+    os.fsync(file.fileno())
+
+
+def write_v2_set(file: BinaryIO, hf: HotfixInfo, codec: int, columnar: bool) -> V2Set:
+    """
+    Compresses a set and writes it at the current position in a v2 archive.
+
+    Args:
+        file: The archive to write to.
+        hf: The hotfixes to write.
+        codec: The codec to compress the set with.
+        columnar: If true, encodes the set in the columnar layout.
+    Returns:
+        The written set, to include in the index.
+    """
+    hotfixes = hf.load()
+    decoded = encode_columnar(hotfixes) if columnar else encode_rows(hotfixes)
+    compressed = compress_block(decoded, codec)
+
+    index_entry = struct.pack(
+        V2_INDEX_ENTRY_FORMAT,
+        file.tell(),
+        len(compressed),
+        len(decoded),
+        hf.num_hotfixes,
+        codec,
+    )
+    file.write(compressed)
+    return V2Set(hf.friendly_name, hf.release_time, index_entry, hf.catalog_entry())
+
+
+def write_v2_index(file: BinaryIO, sets: list[V2Set]) -> None:
+    """
+    Writes the index and footer of a v2 archive, at the current position.
+
+    The footer only gets written once everything before it is on disk, so if this is interrupted
+    while appending, the previous footer stays the last complete one in the file.
+
+    Args:
+        file: The archive to write to.
+        sets: The sets to include in the index, in display order.
+    """
+    index = io.BytesIO()
+    index.write(struct.pack("<I", len(sets)))
+    for idx, v2_set in enumerate(sets):
+        name = f"{idx:03};{v2_set.friendly_name}".encode()
+        index.write(struct.pack("<I", len(name)) + name + v2_set.index_entry)
+    index.write(encode_catalog([v2_set.catalog_entry for v2_set in sets]))
+
+    index_offset = file.tell()
+    file.write(index.getvalue())
+    sync(file)
+    file.write(struct.pack(V2_FOOTER_FORMAT, index_offset, index.tell(), V2_MAGIC))
+    sync(file)
+
+
+def write_v2(
+    output: Path,
+    all_hotfixes: list[HotfixInfo],
+    codec: int = V2_CODEC_ZLIB,
+    columnar: bool = False,
+) -> None:
+    """
+    Writes a v2 archive, where each set is compressed individually, and listed in a footer index.
+
+    Args:
+        output: The path to write to.
+        all_hotfixes: The hotfixes to include.
+        codec: The codec to compress each set with.
+        columnar: If true, encodes each set in the columnar layout.
+    """
+    with output.open("wb") as file:
+        version = V2_COLUMNAR_VERSION if columnar else V2_VERSION
+        file.write(V2_MAGIC + struct.pack("<I", version))
+
+        sets = [write_v2_set(file, hf, codec, columnar) for hf in all_hotfixes]
+        write_v2_index(file, sets)
+
+
+def find_v2_index(file: BinaryIO) -> tuple[int, int]:
+    """
+    Finds the index of a v2 archive, using the last complete footer in the file.
+
+    Args:
+        file: The archive to search.
+    Returns:
+        A tuple of the index's offset and size. The footer directly follows it.
+    """
+    footer_size = struct.calcsize(V2_FOOTER_FORMAT)
+    magic_offset = footer_size - len(V2_MAGIC)
+
+    # Search backwards, overlapping each chunk with the last so we don't miss any footers which
+    # cross the boundary between them
+    chunk_end = file.seek(0, io.SEEK_END)
+    while chunk_end - V2_HEADER_SIZE >= footer_size:
+        chunk_start = max(V2_HEADER_SIZE, chunk_end - V2_FOOTER_SEARCH_CHUNK_SIZE - footer_size)
+        file.seek(chunk_start)
+        chunk = file.read(chunk_end - chunk_start)
+
+        search_end = len(chunk)
+        while (magic_pos := chunk.rfind(V2_MAGIC, magic_offset, search_end)) >= 0:
+            footer_pos = chunk_start + magic_pos - magic_offset
+            index_offset, index_size, _ = struct.unpack_from(
+                V2_FOOTER_FORMAT,
+                chunk,
+                magic_pos - magic_offset,
+            )
+            if index_offset >= V2_HEADER_SIZE and index_offset + index_size == footer_pos:
+                return index_offset, index_size
+            search_end = magic_pos + len(V2_MAGIC) - 1
+
+        chunk_end = chunk_start + footer_size - 1
+
+    raise ValueError("Couldn't find a complete footer in the archive")
+
+
+def read_v2_sets(file: BinaryIO, index_offset: int, index_size: int) -> list[V2Set]:
+    """
+    Reads the sets out of a v2 archive's index.
+
+    Args:
+        file: The archive to read from.
+        index_offset: The offset of the index.
+        index_size: The size of the index.
+    Returns:
+        The sets in the archive, in index order.
+    """
+    file.seek(index_offset)
+    index = file.read(index_size)
+
+    (num_sets,) = struct.unpack_from("<I", index)
+    pos = 4
+
+    names: list[str] = []
+    index_entries: list[bytes] = []
+    index_entry_size = struct.calcsize(V2_INDEX_ENTRY_FORMAT)
+    for _ in range(num_sets):
+        (name_len,) = struct.unpack_from("<I", index, pos)
+        pos += 4
+        # Strip the ordering chars, they get regenerated when writing the new index
+        names.append(index[pos : pos + name_len].decode().partition(";")[2])
+        pos += name_len
+        index_entries.append(index[pos : pos + index_entry_size])
+        pos += index_entry_size
+
+    if index[pos : pos + len(CATALOG_MAGIC)] != CATALOG_MAGIC:
+        raise ValueError("Archive has no catalog, it needs to be rewritten once before appending")
+    (catalog_entry_size,) = struct.unpack_from("<I", index, pos + len(CATALOG_MAGIC))
+    pos += len(CATALOG_MAGIC) + 4
+
+    sets: list[V2Set] = []
+    known_catalog_size = struct.calcsize(CATALOG_ENTRY_FORMAT)
+    for name, index_entry in zip(names, index_entries, strict=True):
+        catalog_entry = index[pos : pos + known_catalog_size]
+        pos += catalog_entry_size
+        _, release_time, _ = struct.unpack(CATALOG_ENTRY_FORMAT, catalog_entry)
+        sets.append(V2Set(name, release_time, index_entry, catalog_entry))
+    return sets
+
+
+def append_v2(output: Path, all_hotfixes: list[HotfixInfo], codec: int = V2_CODEC_ZLIB) -> None:
+    """
+    Appends any new sets to an existing base or columnar v2 archive.
+
+    Sets are matched by their friendly name, any which are already in the archive are left as is.
+    New sets, followed by a new index and footer, are written after the last complete footer, so
+    this only costs as much as the new sets. The previous index is left behind as dead space.
+
+    Args:
+        output: The archive to append to.
+        all_hotfixes: The hotfixes to include.
+        codec: The codec to compress each new set with.
+    """
+    with output.open("r+b") as file:
+        magic, version = struct.unpack("<4sI", file.read(V2_HEADER_SIZE))
+        if magic != V2_MAGIC or version not in {V2_VERSION, V2_COLUMNAR_VERSION}:
+            raise ValueError("Can only append to base or columnar v2 archives")
+
+        index_offset, index_size = find_v2_index(file)
+        sets = read_v2_sets(file, index_offset, index_size)
+
+        # Throw away anything left over from an interrupted append
+        file.truncate(index_offset + index_size + struct.calcsize(V2_FOOTER_FORMAT))
+
+        existing_names = {v2_set.friendly_name for v2_set in sets}
+        new_hotfixes = [hf for hf in all_hotfixes if hf.friendly_name not in existing_names]
+        if not new_hotfixes:
+            return
+
+        file.seek(0, io.SEEK_END)
+        columnar = version == V2_COLUMNAR_VERSION
+        sets.extend(write_v2_set(file, hf, codec, columnar) for hf in new_hotfixes)
+
+        # Same order as a full write - mods by name, then point-in-time files, newest first
+        sets.sort(
+            key=lambda v2_set: (
+                v2_set.release_time != CATALOG_UNKNOWN_TIME,
+                -v2_set.release_time,
+                v2_set.friendly_name,
+            ),
+        )
+        write_v2_index(file, sets)
+
+
+def encode_delta(base: list[int], ids: list[int]) -> bytes:
+    """
+    Encodes a set as a delta against a base set.
+
+    Args:
+        base: The pool ids of the base set.
+        ids: The pool ids of the set to encode.
+    Returns:
+        The encoded delta.
+    """
+    base_pairs = list(zip(base[::2], base[1::2], strict=True))
+    pairs = list(zip(ids[::2], ids[1::2], strict=True))
+
+    delta = io.BytesIO()
+    delta.write(struct.pack("<I", len(pairs)))
+
+    matcher = difflib.SequenceMatcher(None, base_pairs, pairs, autojunk=False)
+    for tag, base_start, base_end, start, end in matcher.get_opcodes():
+        if tag == "equal":
+            delta.write(struct.pack("<II", DELTA_COPY, base_end - base_start))
+            continue
+        if base_end > base_start:
+            delta.write(struct.pack("<II", DELTA_SKIP, base_end - base_start))
+        if end > start:
+            delta.write(struct.pack("<II", DELTA_INSERT, end - start))
+            delta.write(struct.pack(f"<{(end - start) * 2}I", *ids[start * 2 : end * 2]))
+
+    return delta.getvalue()
+
+
+def write_pooled(
+    output: Path,
+    all_hotfixes: list[HotfixInfo],
+    keyframe_interval: int | None = None,
+    codec: int = V2_CODEC_ZLIB,
+) -> None:
+    """
+    Writes a pooled v2 archive, where every unique string is stored once in a shared pool.
+
+    Args:
+        output: The path to write to.
+        all_hotfixes: The hotfixes to include.
+        keyframe_interval: If not None, writes a timeline archive, where sets are stored as deltas
+                           against the previous set, with a full keyframe at least this often.
+        codec: The codec to compress the pool and each set with.
+    """
+    pool: dict[str, int] = {}
+    all_ids: list[list[int]] = []
+    for hf in all_hotfixes:
+        ids: list[int] = []
+        for key, value in hf.load():
+            ids.append(pool.setdefault(key, len(pool)))
+            ids.append(pool.setdefault(value, len(pool)))
+        all_ids.append(ids)
+
+    with output.open("wb") as file:
+        version = V2_POOLED_VERSION if keyframe_interval is None else V2_TIMELINE_VERSION
+        file.write(V2_MAGIC + struct.pack("<I", version))
+
+        index = io.BytesIO()
+
+        decoded_pool = struct.pack("<I", len(pool)) + b"".join(encode_str(x) for x in pool)
+        compressed_pool = compress_block(decoded_pool, codec)
+        index.write(
+            struct.pack(
+                "<QQQIB",
+                file.tell(),
+                len(compressed_pool),
+                len(decoded_pool),
+                len(pool),
+                codec,
+            ),
+        )
+        file.write(compressed_pool)
+
+        index.write(struct.pack("<I", len(all_hotfixes)))
+        chain_length = 0
+        for idx, (hf, ids) in enumerate(zip(all_hotfixes, all_ids, strict=True)):
+            decoded = struct.pack(f"<I{len(ids)}I", hf.num_hotfixes, *ids)
+            compressed = compress_block(decoded, codec)
+
+            base = V2_NO_BASE
+            if keyframe_interval is not None and idx > 0 and chain_length + 1 < keyframe_interval:
+                delta = encode_delta(all_ids[idx - 1], ids)
+                compressed_delta = compress_block(delta, codec)
+                # Sets which changed a lot, e.g. mods, are better off as keyframes anyway
+                if len(compressed_delta) < len(compressed):
+                    base = idx - 1
+                    decoded = delta
+                    compressed = compressed_delta
+            chain_length = 0 if base == V2_NO_BASE else chain_length + 1
+
+            name = f"{idx:03};{hf.friendly_name}".encode("utf8")
+            index.write(struct.pack("<I", len(name)) + name)
+            index.write(
+                struct.pack(
+                    "<QQQIB",
+                    file.tell(),
+                    len(compressed),
+                    len(decoded),
+                    hf.num_hotfixes,
+                    codec,
+                ),
+            )
+            if keyframe_interval is not None:
+                index.write(struct.pack("<I", base))
+            file.write(compressed)
+
+        index.write(encode_catalog([hf.catalog_entry() for hf in all_hotfixes]))
+
+        index_offset = file.tell()
+        file.write(index.getvalue())
+        file.write(struct.pack("<QI", index_offset, index.tell()) + V2_MAGIC)
+
+
 if __name__ == "__main__":
 
     def _existing_dir_parser(arg: str) -> Path:
@@ -135,6 +763,54 @@ if __name__ == "__main__":
         help="A modded hotfix file to include. May be specified multiple times.",
     )
 
+    format_group = parser.add_mutually_exclusive_group()
+    format_group.add_argument(
+        "--legacy",
+        action="store_true",
+        help="Write a legacy .tar.gz archive, rather than the v2 format.",
+    )
+    format_group.add_argument(
+        "--pooled",
+        action="store_true",
+        help="Write a pooled v2 archive, which deduplicates strings across all sets.",
+    )
+    format_group.add_argument(
+        "--timeline",
+        action="store_true",
+        help="Write a pooled v2 archive, which also stores sets as deltas against each other.",
+    )
+    format_group.add_argument(
+        "--append",
+        action="store_true",
+        help=(
+            "Append any sets which aren't already in the output to it, rather than rewriting it."
+            " The output must be a base or columnar v2 archive."
+        ),
+    )
+    format_group.add_argument(
+        "--columnar",
+        action="store_true",
+        help=(
+            "Write a columnar v2 archive, which splits each set into columns of key numbers and"
+            " front coded values."
+        ),
+    )
+    parser.add_argument(
+        "--keyframe-interval",
+        type=int,
+        default=16,
+        help="In timeline archives, the maximum distance between full sets. Defaults to 16.",
+    )
+    parser.add_argument(
+        "--codec",
+        choices=V2_CODECS.keys(),
+        default="zlib",
+        help=(
+            "The codec to compress v2 archives with. Defaults to zlib. zstd decodes several times"
+            " faster, but needs the 'zstandard' package."
+        ),
+    )
+
     args = parser.parse_args()
 
     if args.names is not None:
@@ -145,13 +821,14 @@ if __name__ == "__main__":
     vanilla_hotfixes = get_ordered_hotfixes(args.point_in_time, args.filter)
     all_hotfixes = mod_hotfixes + vanilla_hotfixes
 
-    with tarfile.open(args.output, "w:gz") as tar:
-        for idx, hf in enumerate(all_hotfixes):
-            data = hf.compress()
-
-            info = tar.gettarinfo(hf.path, arcname=f"{idx:03};{hf.friendly_name}")
-            info.size = data.tell()
-            data.seek(0)
-            tar.addfile(info, data)
-
-            data.close()
+    codec = V2_CODECS[args.codec]
+    if args.legacy:
+        write_tar(args.output, all_hotfixes)
+    elif args.pooled:
+        write_pooled(args.output, all_hotfixes, codec=codec)
+    elif args.timeline:
+        write_pooled(args.output, all_hotfixes, max(args.keyframe_interval, 1), codec)
+    elif args.append:
+        append_v2(args.output, all_hotfixes, codec)
+    else:
+        write_v2(args.output, all_hotfixes, codec, args.columnar)
@@ -0,0 +1,334 @@
+#!/usr/bin/env python3
+# ruff: noqa: T201
+import struct
+import time
+import zlib
+from collections.abc import Callable
+from dataclasses import dataclass
+from pathlib import Path
+
+from archive import (
+    V2_CODEC_NONE,
+    V2_CODEC_ZLIB,
+    V2_CODEC_ZSTD,
+    V2_COLUMNAR_VERSION,
+    V2_MAGIC,
+    V2_POOLED_VERSION,
+    V2_TIMELINE_VERSION,
+    V2_VERSION,
+    VARINT_BITS,
+    VARINT_CONTINUE,
+    VARINT_VALUE_MASK,
+    encode_columnar,
+    encode_rows,
+    zstandard,
+)
+
+FOOTER_SIZE = 16
+INDEX_ENTRY_FORMAT = "<QQQIB"
+
+PREFIX_COLUMN = 0
+KEY_COLUMN = 1
+SHARED_LEN_COLUMN = 2
+SUFFIX_LEN_COLUMN = 3
+SUFFIX_COLUMN = 4
+NUM_COLUMNS = 5
+
+
+@dataclass
+class Candidate:
+    name: str
+    compress: Callable[[bytes], bytes]
+    decompress: Callable[[bytes], bytes]
+
+
+def decompress_block(data: bytes, codec: int) -> bytes:
+    """
+    Decompresses a block out of a v2 archive.
+
+    Args:
+        data: The compressed block.
+        codec: The codec the block was compressed with.
+    Returns:
+        The decompressed block.
+    """
+    if codec == V2_CODEC_NONE:
+        return data
+    if codec == V2_CODEC_ZLIB:
+        return zlib.decompress(data)
+    if codec == V2_CODEC_ZSTD and zstandard is not None:
+        return zstandard.ZstdDecompressor().decompress(data)
+    raise ValueError(f"Unsupported codec {codec}")
+
+
+def read_blocks(path: Path) -> tuple[int, dict[str, bytes]]:
+    """
+    Reads and decompresses every block out of a v2 archive.
+
+    Args:
+        path: The archive to read.
+    Returns:
+        A tuple of the archive's version, and a dict mapping each set's name to it's decompressed
+        data. The string pool, if any, is included under an empty name.
+    """
+    data = path.read_bytes()
+
+    magic, version = struct.unpack_from("<4sI", data)
+    if magic != V2_MAGIC or version not in {
+        V2_VERSION,
+        V2_POOLED_VERSION,
+        V2_TIMELINE_VERSION,
+        V2_COLUMNAR_VERSION,
+    }:
+        raise ValueError("Benchmarking requires a v2 archive")
+
+    index_offset, _ = struct.unpack_from("<QI", data, len(data) - FOOTER_SIZE)
+    pos = index_offset
+
+    def read_entry() -> bytes:
+        nonlocal pos
+        offset, compressed_size, _, _, codec = struct.unpack_from(INDEX_ENTRY_FORMAT, data, pos)
+        pos += struct.calcsize(INDEX_ENTRY_FORMAT)
+        return decompress_block(data[offset : offset + compressed_size], codec)
+
+    blocks: dict[str, bytes] = {}
+    if version in {V2_POOLED_VERSION, V2_TIMELINE_VERSION}:
+        blocks[""] = read_entry()
+
+    (num_sets,) = struct.unpack_from("<I", data, pos)
+    pos += 4
+    for _ in range(num_sets):
+        (name_len,) = struct.unpack_from("<I", data, pos)
+        pos += 4
+        name = data[pos : pos + name_len].decode("utf8")
+        pos += name_len
+        blocks[name] = read_entry()
+        if version == V2_TIMELINE_VERSION:
+            pos += 4
+
+    return version, blocks
+
+
+def decode_rows(data: bytes) -> list[tuple[str, str]]:
+    """
+    Decodes a set stored in the base layout.
+
+    Args:
+        data: The decompressed set.
+    Returns:
+        The set's hotfixes.
+    """
+    (num_hotfixes,) = struct.unpack_from("<I", data)
+    pos = 4
+
+    def read_str() -> str:
+        nonlocal pos
+        (length,) = struct.unpack_from("<I", data, pos)
+        pos += 4 + (length * 2)
+        return data[pos - (length * 2) : pos].decode("utf-16le", "surrogatepass")
+
+    return [(read_str(), read_str()) for _ in range(num_hotfixes)]
+
+
+def decode_utf8(value: bytes) -> str:
+    """
+    Decodes a utf8 string written by the columnar layout, which may contain lone surrogates.
+
+    Args:
+        value: The encoded string.
+    Returns:
+        The decoded string.
+    """
+    return value.decode("utf8", "surrogatepass")
+
+
+def decode_columnar(data: bytes) -> list[tuple[str, str]]:
+    """
+    Decodes a set stored in the columnar layout.
+
+    Args:
+        data: The decompressed set.
+    Returns:
+        The set's hotfixes.
+    """
+    num_hotfixes, _ = struct.unpack_from("<II", data)
+    pos = 8
+
+    columns: list[bytes] = []
+    for _ in range(NUM_COLUMNS):
+        (size,) = struct.unpack_from("<I", data, pos)
+        columns.append(data[pos + 4 : pos + 4 + size])
+        pos += 4 + size
+    positions = [0] * NUM_COLUMNS
+
+    def read_varint(column: int) -> int:
+        value = 0
+        shift = 0
+        while True:
+            byte = columns[column][positions[column]]
+            positions[column] += 1
+            value |= (byte & VARINT_VALUE_MASK) << shift
+            shift += VARINT_BITS
+            if (byte & VARINT_CONTINUE) == 0:
+                return value
+
+    def read_bytes(column: int, length: int) -> bytes:
+        positions[column] += length
+        return columns[column][positions[column] - length : positions[column]]
+
+    prefixes: list[bytes] = []
+    while positions[PREFIX_COLUMN] < len(columns[PREFIX_COLUMN]):
+        prefixes.append(read_bytes(PREFIX_COLUMN, read_varint(PREFIX_COLUMN)))
+
+    hotfixes: list[tuple[str, str]] = []
+    last_number = 0
+    value = b""
+    for _ in range(num_hotfixes):
+        code = read_varint(KEY_COLUMN)
+        if code == 0:
+            key = read_bytes(KEY_COLUMN, read_varint(KEY_COLUMN))
+        else:
+            zigzag, prefix_idx = divmod(code - 1, len(prefixes))
+            last_number += 1 + ((zigzag >> 1) ^ -(zigzag & 1))
+            key = prefixes[prefix_idx] + str(last_number).encode()
+
+        shared_len = read_varint(SHARED_LEN_COLUMN)
+        suffix = read_bytes(SUFFIX_COLUMN, read_varint(SUFFIX_LEN_COLUMN))
+        value = value[:shared_len] + suffix
+        hotfixes.append((decode_utf8(key), decode_utf8(value)))
+
+    assert positions == [len(column) for column in columns]
+    return hotfixes
+
+
+def get_layouts(version: int, blocks: list[bytes]) -> dict[str, list[bytes]]:
+    """
+    Gets all the layouts to benchmark the sets in.
+
+    Args:
+        version: The version of the archive the blocks came from.
+        blocks: The decompressed blocks.
+    Returns:
+        A dict mapping each layout's name to the blocks encoded in it.
+    """
+    if version not in {V2_VERSION, V2_COLUMNAR_VERSION}:
+        return {"stored": blocks}
+
+    decode = decode_rows if version == V2_VERSION else decode_columnar
+    all_sets = [decode(block) for block in blocks]
+
+    columnar = [encode_columnar(hotfixes) for hotfixes in all_sets]
+    for hotfixes, block in zip(all_sets, columnar, strict=True):
+        if decode_columnar(block) != hotfixes:
+            raise RuntimeError("Columnar layout didn't rebuild the exact same set")
+
+    return {
+        "rows": [encode_rows(hotfixes) for hotfixes in all_sets],
+        "columnar": columnar,
+    }
+
+
+def get_candidates() -> list[Candidate]:
+    """
+    Gets all the codec + level combinations to benchmark.
+
+    Returns:
+        A list of candidates.
+    """
+    candidates = [
+        Candidate(f"zlib {level}", lambda x, level=level: zlib.compress(x, level), zlib.decompress)
+        for level in (6, 9)
+    ]
+    if zstandard is None:
+        print("'zstandard' package isn't installed, skipping zstd")
+        return candidates
+
+    decompressor = zstandard.ZstdDecompressor()
+    candidates.extend(
+        Candidate(
+            f"zstd {level}",
+            zstandard.ZstdCompressor(level=level).compress,
+            decompressor.decompress,
+        )
+        for level in (3, 19)
+    )
+    return candidates
+
+
+def benchmark(blocks: list[bytes], candidate: Candidate, repeats: int) -> tuple[int, float]:
+    """
+    Benchmarks a single codec.
+
+    Args:
+        blocks: The decompressed blocks to benchmark on.
+        candidate: The codec to benchmark.
+        repeats: How many times to decode each block. The fastest time is used.
+    Returns:
+        A tuple of the total compressed size, and the total time to decode every block, in seconds.
+    """
+    compressed = [candidate.compress(x) for x in blocks]
+
+    best = float("inf")
+    for _ in range(repeats):
+        start = time.perf_counter()
+        for block in compressed:
+            candidate.decompress(block)
+        best = min(best, time.perf_counter() - start)
+
+    return sum(len(x) for x in compressed), best
+
+
+if __name__ == "__main__":
+    import argparse
+
+    def _existing_file_parser(arg: str) -> Path:
+        path = Path(arg)
+        if path.is_file():
+            return path
+        raise argparse.ArgumentTypeError(f"'{arg}' is not a file")
+
+    parser = argparse.ArgumentParser(
+        description=(
+            "Compares how well each codec the dll supports compresses a v2 archive, and how long"
+            " it takes to decode."
+        ),
+    )
+    parser.add_argument("hfdat", type=_existing_file_parser, help="The v2 archive to benchmark.")
+    parser.add_argument(
+        "-s",
+        "--set",
+        help="Only benchmark sets whose names contain this string, rather than all of them.",
+    )
+    parser.add_argument(
+        "-r",
+        "--repeats",
+        type=int,
+        default=5,
+        help="How many times to decode each set. The fastest time is used. Defaults to 5.",
+    )
+
+    args = parser.parse_args()
+
+    version, all_blocks = read_blocks(args.hfdat)
+    blocks = [block for name, block in all_blocks.items() if args.set is None or args.set in name]
+    if not blocks:
+        raise SystemExit("No sets matched")
+
+    layouts = get_layouts(version, blocks)
+
+    # Compare every layout against the same baseline, so ratios and speeds line up between them
+    decoded_size = sum(len(x) for x in next(iter(layouts.values())))
+    print(f"Benchmarking {len(blocks)} blocks, {decoded_size / 1024:.0f} KiB decompressed")
+    print(
+        f"{'Layout':<10} {'Codec':<10} {'Size (KiB)':>12} {'Ratio':>8} {'Decode (ms)':>12}"
+        f" {'MiB/s':>8}",
+    )
+
+    for layout, layout_blocks in layouts.items():
+        for candidate in get_candidates():
+            size, duration = benchmark(layout_blocks, candidate, max(args.repeats, 1))
+            print(
+                f"{layout:<10} {candidate.name:<10} {size / 1024:>12.0f}"
+                f" {decoded_size / size:>8.2f} {duration * 1000:>12.1f}"
+                f" {decoded_size / (1024 * 1024) / duration:>8.0f}",
+            )
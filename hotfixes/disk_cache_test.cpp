@@ -0,0 +1,216 @@
+#include "pch.h"
+
+#include "hfdat/disk_cache.h"
+#include "hfdat/hotfix_set.h"
+#include "test_utils.h"
+
+using namespace dhf;
+using namespace dhf::hfdat;
+
+namespace {
+
+const constexpr auto TEST_DIR_NAME = "dhf_disk_cache_test";
+const constexpr auto SET_NAME = "000;Test Set";
+const constexpr auto OTHER_SET_NAME = "001;Other Set";
+
+// The documented cache layout
+const constexpr auto CACHE_DIR_NAME = "dhf_cache";
+const constexpr auto CACHE_EXTENSION = ".dhfc";
+const constexpr size_t HEADER_SIZE = 32;
+const constexpr uintmax_t CACHE_BUDGET = 512ULL * 1024 * 1024;
+
+// Latin-1 strings, an empty one, and one which can only be stored wide. The first key has an odd
+//  length, so it can't be reinterpreted as a wide string.
+const std::array<std::pair<std::wstring_view, std::wstring_view>, 3> HOTFIXES{{
+    {L"SparkPatchEntry10", L"(1,1,0,),/Game/Some/Path.Path,Attr,0,,Caf\u00E9"},
+    {L"SparkPatchEntry11", L""},
+    {L"SparkPatchEntry12", L"\U0001F914"},
+}};
+
+/**
+ * @brief Creates the set of hotfixes used throughout the test.
+ *
+ * @return The set.
+ */
+HotfixSet create_set(void) {
+    size_t num_chars = 0;
+    for (const auto& [key, value] : HOTFIXES) {
+        num_chars += key.size() + value.size();
+    }
+
+    HotfixSet hotfixes{HOTFIXES.size(), num_chars};
+    for (const auto& [key, value] : HOTFIXES) {
+        hotfixes.push_back(key.data(), key.size(), value.data(), value.size());
+    }
+    hotfixes.shrink_to_fit();
+    return hotfixes;
+}
+
+/**
+ * @brief Checks that a set holds exactly the test hotfixes.
+ *
+ * @param hotfixes The set to check.
+ * @return True if the set matches.
+ */
+bool matches_set(const HotfixSet& hotfixes) {
+    if (hotfixes.size() != HOTFIXES.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < HOTFIXES.size(); i++) {
+        if (hotfixes.key(i).to_wstr() != HOTFIXES[i].first
+            || hotfixes.value(i).to_wstr() != HOTFIXES[i].second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Lists all the cache files in a cache folder.
+ *
+ * @param cache_dir The cache folder.
+ * @return The paths of every cache file.
+ */
+std::vector<std::filesystem::path> list_cache_files(const std::filesystem::path& cache_dir) {
+    std::vector<std::filesystem::path> paths;
+    for (const auto& dir_entry : std::filesystem::directory_iterator{cache_dir}) {
+        if (dir_entry.path().extension() == CACHE_EXTENSION) {
+            paths.push_back(dir_entry.path());
+        }
+    }
+    return paths;
+}
+
+/**
+ * @brief Overwrites a file with new contents.
+ *
+ * @param path The path to the file.
+ * @param data The new contents.
+ */
+void write_file(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+}
+
+/**
+ * @brief Reads a whole file.
+ *
+ * @param path The path to the file.
+ * @return The file's contents.
+ */
+std::vector<uint8_t> read_file(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+/**
+ * @brief Checks that a corrupted cache file gets rejected, and deleted.
+ *
+ * @param cache_dir The cache folder.
+ * @param name A description of how the file is corrupted.
+ * @param corrupt A function which corrupts the file's contents.
+ */
+void check_corrupt_file(const std::filesystem::path& cache_dir,
+                        std::string_view name,
+                        void (*corrupt)(std::vector<uint8_t>& data)) {
+    // Start from an empty cache, so the only file is the one we're about to store
+    std::filesystem::remove_all(cache_dir);
+    disk_cache::store(SET_NAME, create_set());
+
+    auto paths = list_cache_files(cache_dir);
+    test::check(paths.size() == 1, std::format("{}: set is stored in one file", name));
+    if (paths.size() != 1) {
+        return;
+    }
+    const auto& path = paths.front();
+
+    auto data = read_file(path);
+    corrupt(data);
+    write_file(path, data);
+
+    HotfixSet hotfixes{};
+    test::check(!disk_cache::load(SET_NAME, hotfixes),
+                std::format("{}: corrupted file is rejected", name));
+    test::check(hotfixes.empty(), std::format("{}: output set is left alone", name));
+    test::check(!std::filesystem::exists(path), std::format("{}: corrupted file is deleted", name));
+}
+
+}  // namespace
+
+int main(void) {
+    auto test_dir = std::filesystem::temp_directory_path() / TEST_DIR_NAME;
+    std::filesystem::remove_all(test_dir);
+    std::filesystem::create_directories(test_dir);
+
+    // The cache only ever fingerprints the hfdat, it doesn't need to be valid
+    auto hfdat_path = test_dir / "test.hfdat";
+    const std::vector<uint8_t> hfdat_contents{'D', 'H', 'F', '2', 2, 0, 0, 0};
+    write_file(hfdat_path, hfdat_contents);
+    disk_cache::init(hfdat_path);
+    auto cache_dir = test_dir / CACHE_DIR_NAME;
+
+    {
+        HotfixSet hotfixes{};
+        test::check(!disk_cache::load(SET_NAME, hotfixes), "uncached sets aren't found");
+
+        disk_cache::store(SET_NAME, create_set());
+        test::check(disk_cache::load(SET_NAME, hotfixes), "stored sets are found");
+        test::check(matches_set(hotfixes), "stored sets round trip");
+
+        HotfixSet other{};
+        test::check(!disk_cache::load(OTHER_SET_NAME, other), "sets are keyed by name");
+    }
+
+    {
+        auto modified_contents = hfdat_contents;
+        modified_contents.push_back(0);
+        write_file(hfdat_path, modified_contents);
+        disk_cache::init(hfdat_path);
+
+        HotfixSet hotfixes{};
+        test::check(!disk_cache::load(SET_NAME, hotfixes), "changing the hfdat invalidates sets");
+
+        write_file(hfdat_path, hfdat_contents);
+        disk_cache::init(hfdat_path);
+        test::check(disk_cache::load(SET_NAME, hotfixes), "restoring the hfdat finds sets again");
+    }
+
+    check_corrupt_file(cache_dir, "truncated",
+                       [](std::vector<uint8_t>& data) { data.resize(data.size() / 2); });
+    check_corrupt_file(cache_dir, "bad magic",
+                       [](std::vector<uint8_t>& data) { data[0] ^= 0xFF; });
+    check_corrupt_file(cache_dir, "extra data",
+                       [](std::vector<uint8_t>& data) { data.push_back(0); });
+    check_corrupt_file(cache_dir, "offsets past the end", [](std::vector<uint8_t>& data) {
+        // NOLINTNEXTLINE(readability-magic-numbers)
+        std::fill_n(&data[HEADER_SIZE + sizeof(uint32_t)], sizeof(uint32_t), 0x7F);
+    });
+    check_corrupt_file(cache_dir, "odd length wide string", [](std::vector<uint8_t>& data) {
+        uint32_t offset{};
+        memcpy(&offset, &data[HEADER_SIZE + sizeof(uint32_t)], sizeof(offset));
+        offset |= StringPool::WIDE_FLAG;
+        memcpy(&data[HEADER_SIZE + sizeof(uint32_t)], &offset, sizeof(offset));
+    });
+
+    {
+        // Pretend an old set already fills the whole budget, storing another should evict it
+        std::filesystem::remove_all(cache_dir);
+        std::filesystem::create_directories(cache_dir);
+        auto old_path = cache_dir / (std::string{"old_set"} + CACHE_EXTENSION);
+        write_file(old_path, {});
+        std::filesystem::resize_file(old_path, CACHE_BUDGET);
+        std::filesystem::last_write_time(
+            old_path, std::filesystem::file_time_type::clock::now() - std::chrono::hours{1});
+
+        disk_cache::store(OTHER_SET_NAME, create_set());
+        test::check(!std::filesystem::exists(old_path), "least recently used sets get evicted");
+        test::check(list_cache_files(cache_dir).size() == 1,
+                    "newly stored sets don't get evicted");
+
+        HotfixSet hotfixes{};
+        test::check(disk_cache::load(OTHER_SET_NAME, hotfixes), "newly stored sets are found");
+    }
+
+    std::filesystem::remove_all(test_dir);
+    return test::exit_code();
+}
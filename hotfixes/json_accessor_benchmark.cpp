@@ -0,0 +1,198 @@
+#include "pch.h"
+
+#include "hotfixes/hooks.h"
+#include "hotfixes/json.h"
+#include "hotfixes/unreal.h"
+
+using namespace dhf;
+using namespace dhf::hotfixes;
+
+// Count every heap allocation, the whole point of the new accessors is to avoid them
+namespace {
+std::atomic<uint64_t> num_allocations = 0;
+}  // namespace
+
+void* operator new(size_t len) {
+    num_allocations++;
+    auto ret = std::malloc(len);
+    if (ret == nullptr) {
+        throw std::bad_alloc{};
+    }
+    return ret;
+}
+void operator delete(void* data) noexcept {
+    std::free(data);
+}
+void operator delete(void* data, size_t /*len*/) noexcept {
+    std::free(data);
+}
+
+namespace {
+
+const constexpr uint32_t NUM_HOTFIXES = 20000;
+const constexpr uint32_t NUM_SERVICE_LOOKUPS = 100000;
+const constexpr size_t NUM_REPEATS = 3;
+
+// The vf tables are only ever compared, they just need unique addresses
+char fake_vf_table;
+
+#pragma region Baseline
+
+// The accessors as they were before, converting every key into a wide string, and throwing when
+//  they're missing
+
+template <typename T>
+T* baseline_cast(FJsonValue* value, EJson type) {
+    if (value->type != type) {
+        throw std::runtime_error("JSON object was of unexpected type "
+                                 + std::to_string((uint32_t)value->type));
+    }
+    return reinterpret_cast<T*>(value);
+}
+
+template <typename T>
+T* baseline_get(const FJsonObject* obj, const std::wstring& key, EJson type) {
+    for (uint32_t i = 0; i < obj->entries.count; i++) {
+        auto entry = obj->entries.data[i];
+        if (entry.key.to_wstr() == key) {
+            return baseline_cast<T>(entry.value.obj, type);
+        }
+    }
+    throw std::runtime_error("Couldn't find key!");
+}
+
+#pragma endregion
+
+/**
+ * @brief Advances a crc over a json string, the same way the discovery hook hashes them.
+ *
+ * @param crc The crc to advance.
+ * @param str The string to hash.
+ */
+void hash_string(uLong& crc, const FString& str) {
+    crc = crc32_z(crc, reinterpret_cast<const Bytef*>(str.data), str.count * sizeof(wchar_t));
+}
+
+/**
+ * @brief Times a function, and counts how many allocations it makes.
+ *
+ * @param func The function to time.
+ * @return A pair of the time taken, in microseconds, and the amount of allocations made.
+ */
+template <typename Func>
+std::pair<double, uint64_t> measure(Func&& func) {
+    auto allocations = num_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto duration = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+        std::chrono::steady_clock::now() - start);
+    return {duration.count(), num_allocations - allocations};
+}
+
+/**
+ * @brief Prints the result of a benchmark.
+ *
+ * @param name The name of the benchmark.
+ * @param baseline The baseline measurement.
+ * @param current The measurement using the current accessors.
+ */
+void print_result(std::string_view name,
+                  std::pair<double, uint64_t> baseline,
+                  std::pair<double, uint64_t> current) {
+    std::cout << std::format("{:<24} baseline {:>8.0f}us {:>7} allocs | current {:>8.0f}us {:>7} "
+                             "allocs\n",
+                             name, baseline.first, baseline.second, current.first,
+                             current.second);
+}
+
+}  // namespace
+
+int main(void) {
+    set_allocator(get_stand_in_allocator());
+    vf_table.json_value_string = &fake_vf_table;
+    vf_table.json_value_array = &fake_vf_table;
+    vf_table.json_value_object = &fake_vf_table;
+    vf_table.shared_ptr_json_value = &fake_vf_table;
+    vf_table.shared_ptr_json_object = &fake_vf_table;
+
+    // Parameters shaped like the game's micropatch hotfixes
+    FJsonValueArray params{};
+    params.type = EJson::ARRAY;
+    params.entries.count = NUM_HOTFIXES;
+    params.entries.max = NUM_HOTFIXES;
+    params.entries.data =
+        u_malloc<TSharedPtr<FJsonValue>>(NUM_HOTFIXES * sizeof(TSharedPtr<FJsonValue>));
+    for (uint32_t i = 0; i < NUM_HOTFIXES; i++) {
+        auto key = std::format(L"SparkPatchEntry{}", i);
+        auto value = std::format(L"(1,1,0,),/Game/Some/Long/Path.Path,Attr,0,,Value{}", i);
+        params.entries.data[i].obj = create_json_value_object(create_json_object<2>(
+            {{{L"key", create_json_string(key)}, {L"value", create_json_string(value)}}}));
+    }
+
+    auto service = create_json_object<2>({{{L"configuration_group", create_json_string(L"grp")},
+                                           {L"service_name", create_json_string(L"Micropatch")}}});
+
+    for (size_t repeat = 0; repeat < NUM_REPEATS; repeat++) {
+        uLong baseline_crc = crc32_z(0, nullptr, 0);
+        auto baseline_hash = measure([&]() {
+            for (uint32_t i = 0; i < NUM_HOTFIXES; i++) {
+                auto entry =
+                    baseline_cast<FJsonValueObject>(params.entries.data[i].obj, EJson::OBJECT)
+                        ->to_obj();
+                hash_string(baseline_crc,
+                            baseline_get<FJsonValueString>(entry, L"key", EJson::STRING)->str);
+                hash_string(baseline_crc,
+                            baseline_get<FJsonValueString>(entry, L"value", EJson::STRING)->str);
+            }
+        });
+
+        uLong current_crc = crc32_z(0, nullptr, 0);
+        auto current_hash = measure([&]() {
+            for (uint32_t i = 0; i < NUM_HOTFIXES; i++) {
+                auto entry = params.find<FJsonValueObject>(i)->to_obj();
+                hash_string(current_crc, entry->find<FJsonValueString>(L"key")->str);
+                hash_string(current_crc, entry->find<FJsonValueString>(L"value")->str);
+            }
+        });
+
+        if (baseline_crc != current_crc) {
+            std::cerr << "[dhf] Accessors hashed different strings\n";
+            return 1;
+        }
+        print_result(std::format("hash {} hotfixes", NUM_HOTFIXES), baseline_hash, current_hash);
+
+        uint32_t baseline_hits = 0;
+        auto baseline_lookup = measure([&]() {
+            for (uint32_t i = 0; i < NUM_SERVICE_LOOKUPS; i++) {
+                baseline_hits +=
+                    baseline_get<FJsonValueString>(service, L"service_name", EJson::STRING)
+                        ->to_wstr()
+                    == L"Micropatch";
+            }
+        });
+
+        uint32_t current_hits = 0;
+        auto current_lookup = measure([&]() {
+            for (uint32_t i = 0; i < NUM_SERVICE_LOOKUPS; i++) {
+                auto name = service->find<FJsonValueString>(L"service_name");
+                current_hits += name != nullptr && name->equals(L"Micropatch");
+            }
+        });
+
+        if (baseline_hits != current_hits) {
+            std::cerr << "[dhf] Accessors found different service names\n";
+            return 1;
+        }
+        print_result(std::format("{} service lookups", NUM_SERVICE_LOOKUPS), baseline_lookup,
+                     current_lookup);
+    }
+
+    // Both are shaped like our parameters, so can be freed the same way
+    for (uint32_t i = 0; i < NUM_HOTFIXES; i++) {
+        free_param_entry(params.entries.data[i]);
+    }
+    u_free(params.entries.data);
+    free_param_entry({create_json_value_object(service), nullptr});
+
+    return 0;
+}
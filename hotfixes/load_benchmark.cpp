@@ -0,0 +1,242 @@
+#include "pch.h"
+
+#include "archive.h"
+#include "archive_entry.h"
+#include "hfdat/decode.h"
+#include "hfdat/hotfix_set.h"
+#include "hfdat/tar.h"
+#include "hfdat/v2.h"
+
+using namespace dhf;
+using namespace dhf::hfdat;
+
+namespace {
+
+const constexpr size_t DEFAULT_NUM_REPEATS = 3;
+
+// Both libarchive readers use the block size the fallback originally used, so that the only
+//  difference between them is how they read each entry
+const constexpr auto ARCHIVE_BLOCK_SIZE = 0x4000;
+const constexpr size_t READ_CHUNK_SIZE = 0x40000;
+
+using Clock = std::chrono::steady_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+/**
+ * @brief Opens an archive, and skips to the entry holding a set.
+ *
+ * @param path The path to the archive.
+ * @param name The name of the set.
+ * @return A pair of the archive, and the size of the set's entry.
+ */
+std::pair<std::shared_ptr<archive>, size_t> open_to_set(const std::filesystem::path& path,
+                                                        const std::string& name) {
+    std::shared_ptr<archive> ptr{
+        archive_read_new(), [](void* data) { archive_free(reinterpret_cast<archive*>(data)); }};
+
+    archive_read_support_filter_all(ptr.get());
+    archive_read_support_format_all(ptr.get());
+
+    auto ret =
+        archive_read_open_filename(ptr.get(), path.generic_string().c_str(), ARCHIVE_BLOCK_SIZE);
+    if (ret != ARCHIVE_OK) {
+        throw std::runtime_error("Failed to open archive: " + std::to_string(ret));
+    }
+
+    archive_entry* entry{};
+    while (archive_read_next_header(ptr.get(), &entry) == ARCHIVE_OK) {
+        if (name == archive_entry_pathname_utf8(entry)) {
+            return {ptr, (size_t)archive_entry_size(entry)};
+        }
+    }
+    throw std::runtime_error("Couldn't find hotfixes in archive");
+}
+
+#pragma region Baseline
+
+// The libarchive fallback as it was before, making multiple reads per hotfix, and allocating a
+//  pair of strings for each
+
+using BaselineHotfixes = std::vector<std::pair<std::wstring, std::wstring>>;
+
+template <typename T>
+T baseline_read(const std::shared_ptr<archive>& archive) {
+    T value;
+    auto ret = archive_read_data(archive.get(), &value, sizeof(value));
+    if (ret < (la_ssize_t)sizeof(value)) {
+        throw std::runtime_error("Fail to read from archive: " + std::to_string(ret));
+    }
+    return value;
+}
+
+std::wstring baseline_read_string(const std::shared_ptr<archive>& archive, size_t len) {
+    auto byte_len = sizeof(wchar_t) * len;
+
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc, cppcoreguidelines-owning-memory)
+    auto* buf = reinterpret_cast<wchar_t*>(malloc(byte_len));
+
+    auto ret = archive_read_data(archive.get(), buf, byte_len);
+    if (ret < (la_ssize_t)byte_len) {
+        throw std::runtime_error("Fail to read from archive: " + std::to_string(ret));
+    }
+
+    std::wstring str{buf, len};
+    // NOLINTNEXTLINE(cppcoreguidelines-no-malloc, cppcoreguidelines-owning-memory)
+    free(buf);
+
+    return str;
+}
+
+BaselineHotfixes baseline_load(const std::shared_ptr<archive>& archive) {
+    auto num_hotfixes = baseline_read<uint32_t>(archive);
+
+    BaselineHotfixes hotfixes;
+    hotfixes.reserve(num_hotfixes);
+
+    for (uint32_t i = 0; i < num_hotfixes; i++) {
+        auto key_size = baseline_read<uint32_t>(archive);
+        auto key = baseline_read_string(archive, key_size);
+
+        auto value_size = baseline_read<uint32_t>(archive);
+        auto value = baseline_read_string(archive, value_size);
+
+        hotfixes.emplace_back(std::move(key), std::move(value));
+    }
+
+    return hotfixes;
+}
+
+#pragma endregion
+
+/**
+ * @brief Loads a set through libarchive the current way, reading the whole entry in large chunks
+ *        before parsing it.
+ *
+ * @param archive The archive to read from, positioned at the set's entry.
+ * @param size The size of the set's entry.
+ * @param hotfixes The set to load the hotfixes into.
+ */
+void bulk_load(const std::shared_ptr<archive>& archive, size_t size, HotfixSet& hotfixes) {
+    std::vector<uint8_t> data(size);
+    size_t filled = 0;
+    while (filled < size) {
+        auto ret = archive_read_data(archive.get(), &data[filled],
+                                     std::min(size - filled, READ_CHUNK_SIZE));
+        if (ret <= 0) {
+            throw std::runtime_error("Fail to read from archive: " + std::to_string(ret));
+        }
+        filled += (size_t)ret;
+    }
+
+    parse_hotfixes(data.data(), data.size(), hotfixes);
+}
+
+/**
+ * @brief Compares the old and new ways of reading sets through libarchive, which is what every
+ *        tar based load falls back to.
+ * @note Only times reading the set's entry. Skipping to it costs the same either way, and in
+ *       compressed archives can easily drown out the difference.
+ *
+ * @param path The path to the archive.
+ * @param names The names of every set in the archive.
+ * @param num_repeats How many times to load every set.
+ */
+void compare_archive_readers(const std::filesystem::path& path,
+                             const std::vector<std::string>& names,
+                             size_t num_repeats) {
+    for (size_t repeat = 0; repeat < num_repeats; repeat++) {
+        Milliseconds baseline_total{0};
+        Milliseconds bulk_total{0};
+
+        for (const auto& name : names) {
+            auto [baseline_archive, baseline_size] = open_to_set(path, name);
+            auto start = Clock::now();
+            auto baseline = baseline_load(baseline_archive);
+            Milliseconds baseline_duration{Clock::now() - start};
+
+            auto [bulk_archive, bulk_size] = open_to_set(path, name);
+            HotfixSet hotfixes{};
+            start = Clock::now();
+            bulk_load(bulk_archive, bulk_size, hotfixes);
+            Milliseconds bulk_duration{Clock::now() - start};
+
+            if (baseline.size() != hotfixes.size()) {
+                throw std::runtime_error("Readers disagree on the amount of hotfixes in " + name);
+            }
+
+            baseline_total += baseline_duration;
+            bulk_total += bulk_duration;
+
+            if (repeat == 0) {
+                std::cout << std::format(
+                    "[dhf] {:>8} hotfixes: per field {:>8.1f}ms, bulk {:>8.1f}ms  {}\n",
+                    hotfixes.size(), baseline_duration.count(), bulk_duration.count(), name);
+            }
+        }
+
+        std::cout << std::format(
+            "[dhf] Pass {}: libarchive per field {:.1f}ms, bulk {:.1f}ms ({:.2f}x)\n", repeat,
+            baseline_total.count(), bulk_total.count(), baseline_total / bulk_total);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "[dhf] Usage: load_benchmark <hfdat> [repeats]\n";
+        return 1;
+    }
+    const std::filesystem::path path{argv[1]};
+    auto num_repeats = argc > 2 ? (size_t)std::stoull(argv[2]) : DEFAULT_NUM_REPEATS;
+
+    try {
+        auto is_v2 = v2::is_v2(path);
+
+        auto start = Clock::now();
+        auto names = is_v2 ? v2::init(path) : tar::init(path);
+        std::cout << std::format("[dhf] Read {} set names from a {} file in {:.1f}ms\n",
+                                 names.size(), is_v2 ? "v2" : "tar",
+                                 Milliseconds{Clock::now() - start}.count());
+
+        for (size_t repeat = 0; repeat < num_repeats; repeat++) {
+            Milliseconds total{0};
+            size_t total_hotfixes = 0;
+            size_t total_bytes = 0;
+
+            for (size_t idx = 0; idx < names.size(); idx++) {
+                HotfixSet hotfixes{};
+                start = Clock::now();
+                if (is_v2) {
+                    v2::load(idx, hotfixes);
+                } else {
+                    tar::load(idx, hotfixes);
+                }
+                Milliseconds duration{Clock::now() - start};
+
+                total += duration;
+                total_hotfixes += hotfixes.size();
+                total_bytes += hotfixes.memory_usage();
+
+                if (repeat == 0) {
+                    std::cout << std::format("[dhf] {:>8} hotfixes in {:>8.1f}ms  {}\n",
+                                             hotfixes.size(), duration.count(), names[idx]);
+                }
+            }
+
+            std::cout << std::format(
+                "[dhf] Pass {}: loaded {} hotfixes ({} KiB) from {} sets in {:.1f}ms\n", repeat,
+                // NOLINTNEXTLINE(readability-magic-numbers)
+                total_hotfixes, total_bytes / 1024, names.size(), total.count());
+        }
+
+        if (!is_v2) {
+            compare_archive_readers(path, names, num_repeats);
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "[dhf] Failed to load hfdat: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
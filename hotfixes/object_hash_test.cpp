@@ -0,0 +1,260 @@
+#include "pch.h"
+
+#include "hotfixes/hooks.h"
+#include "hotfixes/json.h"
+#include "hotfixes/unreal.h"
+#include "test_utils.h"
+
+using namespace dhf;
+using namespace dhf::hotfixes;
+
+namespace {
+
+// The first few entries of Unreal's `FCrc::CRCTable_DEPRECATED`, and it's last
+const constexpr std::array<uint32_t, 4> KNOWN_TABLE_START{0x00000000, 0x04C11DB7, 0x09823B6E,
+                                                          0x0D4326D9};
+const constexpr uint32_t KNOWN_TABLE_END = 0xB1F740B4;
+
+// Keys all have the same length, so that they can be looked up through the literal templates
+const constexpr size_t KEY_SIZE = std::char_traits<wchar_t>::length(L"key_00000") + 1;
+using Key = std::array<wchar_t, KEY_SIZE>;
+
+// The vf tables are only ever compared, they just need unique addresses
+char fake_vf_table;
+
+/**
+ * @brief Creates the key for an entry.
+ *
+ * @param idx The index of the entry.
+ * @return The key.
+ */
+Key create_key(size_t idx) {
+    Key key{};
+    // Spread the numbers out a bit, so the keys don't just differ in their last few chars
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    auto str = std::format(L"key_{:05}", (idx * 7919) % 100000);
+    std::copy_n(str.begin(), KEY_SIZE - 1, key.begin());
+    return key;
+}
+
+/**
+ * @brief Calculates a key's hash the slow way, to check against `strihash`.
+ * @note Follows `FCrc::Strihash_DEPRECATED` directly, working out each table entry bit by bit
+ *       rather than sharing `strihash`'s table.
+ * @note There's no bucket index captured from a game-built object to check this against yet, so
+ *       it only proves `strihash` matches Unreal's source.
+ *
+ * @param key The key to hash.
+ * @return The hash.
+ */
+uint32_t reference_strihash(std::wstring_view key) {
+    // NOLINTBEGIN(readability-magic-numbers)
+    auto table_entry = [](uint32_t idx) {
+        auto crc = idx << 24;
+        for (auto bit = 0; bit < 8; bit++) {
+            crc = (crc << 1) ^ ((crc & 0x80000000) != 0 ? 0x04C11DB7 : 0);
+        }
+        return crc;
+    };
+
+    uint32_t hash = 0;
+    for (auto chr : key) {
+        chr = (wchar_t)std::towupper(chr);
+        auto val = (uint16_t)chr;
+        hash = ((hash >> 8) & 0x00FFFFFF) ^ table_entry((hash ^ val) & 0xFF);
+        val >>= 8;
+        hash = ((hash >> 8) & 0x00FFFFFF) ^ table_entry((hash ^ val) & 0xFF);
+    }
+    return hash;
+    // NOLINTEND(readability-magic-numbers)
+}
+
+/**
+ * @brief Creates an object holding the given entries, with it's hash built the same way as the
+ *        objects we hand to the game.
+ * @note `create_json_object` refuses to build objects large enough to be hashed, so this builds
+ *       them by hand.
+ *
+ * @param entries Key-value pairs of the object's entries.
+ * @return A pointer to the new object.
+ */
+FJsonObject* create_object(const std::vector<std::pair<std::wstring_view, FJsonValue*>>& entries) {
+    auto obj = u_malloc<FJsonObject>(sizeof(FJsonObject));
+
+    obj->entries.count = (uint32_t)entries.size();
+    obj->entries.max = obj->entries.count;
+    obj->entries.data = u_malloc<JSONObjectEntry>(entries.size() * sizeof(JSONObjectEntry));
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        alloc_string(&obj->entries.data[i].key, entries[i].first);
+        obj->entries.data[i].value.obj = entries[i].second;
+        add_ref_controller(&obj->entries.data[i].value, vf_table.shared_ptr_json_value);
+    }
+
+    build_object_hash(obj);
+    return obj;
+}
+
+/**
+ * @brief Frees an object created by `create_object`, and all the strings it holds.
+ *
+ * @param obj The object to free.
+ */
+void free_object(FJsonObject* obj) {
+    TSharedPtr<FJsonValue> entry{create_json_value_object(obj), nullptr};
+    add_ref_controller(&entry, vf_table.shared_ptr_json_value);
+    free_param_entry(entry);
+}
+
+/**
+ * @brief Builds an object with the given amount of entries, and checks every key can be found.
+ *
+ * @param n The amount of entries.
+ */
+void check_object(size_t n) {
+    std::vector<Key> keys;
+    std::vector<std::pair<std::wstring_view, FJsonValue*>> entries(n);
+    for (size_t i = 0; i < n; i++) {
+        keys.push_back(create_key(i));
+    }
+    for (size_t i = 0; i < n; i++) {
+        entries[i] = {{keys[i].data(), KEY_SIZE - 1}, create_json_string(L"value")};
+    }
+
+    auto obj = create_object(entries);
+    auto name = std::format("{} entries", n);
+
+    uint32_t expected_size = 1;
+    if (n >= MIN_HASHED_ELEMENTS) {
+        expected_size = std::bit_ceil((uint32_t)(n / AVG_ELEMENTS_PER_BUCKET + BASE_HASH_BUCKETS));
+    }
+    test::check((uint32_t)obj->hash_size == expected_size, name + ": hash has the right size");
+
+    bool all_hashed = true;
+    bool all_found = true;
+    for (size_t i = 0; i < n; i++) {
+        const auto& key = obj->entries.data[i].key;
+        test::check(strihash({key.data, key.count - 1}) == reference_strihash(key.data),
+                    name + ": strihash matches the reference");
+        test::check(obj->allocation_flags.is_set((uint32_t)i), name + ": entry is allocated");
+
+        const wchar_t(&literal)[KEY_SIZE] = *reinterpret_cast<const wchar_t(*)[KEY_SIZE]>(
+            keys[i].data());
+        all_hashed &= obj->find_hashed_value(literal) == entries[i].second;
+        all_found &= obj->find_value(literal) == entries[i].second;
+    }
+    test::check(all_hashed, name + ": every key is reachable through the hash");
+    test::check(all_found, name + ": every key is found");
+    test::check(!obj->allocation_flags.is_set((uint32_t)n), name + ": no extra entries");
+    test::check(obj->find_value(L"key_missing") == nullptr, name + ": missing keys aren't found");
+
+    free_object(obj);
+}
+
+/**
+ * @brief Checks lookups on an object with a broken hash, which should fall back to the linear scan.
+ *
+ * @param name A description of how the hash is broken.
+ * @param corrupt A function which breaks the hash of the object it's passed.
+ * @param found True if the key should still be found.
+ */
+void check_corrupt_hash(std::string_view name, void (*corrupt)(FJsonObject* obj), bool found) {
+    auto obj = create_object({
+        {L"alpha", create_json_string(L"a")},
+        {L"bravo", create_json_string(L"b")},
+        {L"charlie", create_json_string(L"c")},
+        {L"delta", create_json_string(L"d")},
+        {L"echo", create_json_string(L"e")},
+    });
+    auto expected = found ? obj->entries.data[2].value.obj : nullptr;
+
+    // Keep hold of the original allocations, so the object can still be freed
+    auto hash = obj->hash;
+    auto hash_size = obj->hash_size;
+    auto allocation_flags = obj->allocation_flags;
+    corrupt(obj);
+
+    test::check(obj->find_value(L"charlie") == expected,
+                std::format("{}: lookup falls back to the linear scan", name));
+    test::check(obj->find_value(L"missing") == nullptr,
+                std::format("{}: missing keys aren't found", name));
+
+    obj->hash = hash;
+    obj->hash_size = hash_size;
+    obj->allocation_flags = allocation_flags;
+    free_object(obj);
+}
+
+}  // namespace
+
+int main(void) {
+    set_allocator(test::COUNTING_ALLOCATOR);
+    vf_table.json_value_string = &fake_vf_table;
+    vf_table.json_value_array = &fake_vf_table;
+    vf_table.json_value_object = &fake_vf_table;
+    vf_table.shared_ptr_json_value = &fake_vf_table;
+    vf_table.shared_ptr_json_object = &fake_vf_table;
+
+    static_assert(strihash(L"service_name") == strihash(L"SERVICE_NAME"));
+    test::check(std::equal(KNOWN_TABLE_START.begin(), KNOWN_TABLE_START.end(),
+                           STRIHASH_CRC_TABLE.begin())
+                    && STRIHASH_CRC_TABLE.back() == KNOWN_TABLE_END,
+                "strihash uses unreal's crc table");
+    for (auto key : {L"key", L"value", L"service_name", L"configuration_group", L"parameters"}) {
+        test::check(strihash(key) == reference_strihash(key),
+                    "strihash of a real key matches the reference");
+    }
+
+    // The largest object we can create, which only uses a single bucket
+    {
+        auto obj = create_json_object<MIN_HASHED_ELEMENTS - 1>({{
+            {L"alpha", create_json_string(L"a")},
+            {L"bravo", create_json_string(L"b")},
+            {L"charlie", create_json_string(L"c")},
+        }});
+        test::check(obj->hash_size == 1, "created objects fit in a single bucket");
+        test::check(obj->find_hashed_value(L"charlie") == obj->entries.data[2].value.obj,
+                    "created objects are reachable through the hash");
+        free_object(obj);
+    }
+
+    // Around each of the points where the hash grows, or the allocation flags move to the heap
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    for (size_t n : {1, 2, 3, 4, 5, 17, 64, 128, 129, 300}) {
+        check_object(n);
+    }
+
+    check_corrupt_hash(
+        "chain loops",
+        [](FJsonObject* obj) {
+            for (uint32_t i = 0; i < obj->entries.count; i++) {
+                obj->entries.data[i].hash_next_id = (int32_t)i;
+            }
+        },
+        true);
+    check_corrupt_hash(
+        "chain points past the end",
+        [](FJsonObject* obj) {
+            std::fill_n(obj->hash.get(), obj->hash_size, (int32_t)obj->entries.count);
+        },
+        true);
+    check_corrupt_hash(
+        "chain points at a free entry",
+        [](FJsonObject* obj) { obj->allocation_flags.data.get()[0] &= ~(1U << 2); }, false);
+    check_corrupt_hash(
+        "hash size isn't a power of two",
+        [](FJsonObject* obj) { obj->hash_size = 3; },  // NOLINT(readability-magic-numbers)
+        true);
+    check_corrupt_hash("hash has no buckets", [](FJsonObject* obj) { obj->hash_size = 0; }, true);
+    check_corrupt_hash(
+        "hash is missing it's buckets",
+        [](FJsonObject* obj) { obj->hash.secondary_data = nullptr; }, true);
+    check_corrupt_hash(
+        "allocation flags are too short",
+        [](FJsonObject* obj) { obj->allocation_flags.num_bits = 1; }, false);
+
+    test::check(test::live_allocations == 0, "every object gets freed");
+
+    set_allocator(get_stand_in_allocator());
+    return test::exit_code();
+}
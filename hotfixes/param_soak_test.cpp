@@ -0,0 +1,319 @@
+#include "pch.h"
+
+#include "hfdat/hfdat.h"
+#include "hotfixes/hooks.h"
+#include "hotfixes/json.h"
+#include "hotfixes/processing.h"
+#include "hotfixes/unreal.h"
+#include "test_utils.h"
+
+using namespace dhf;
+using namespace dhf::hotfixes;
+
+namespace {
+
+const constexpr size_t NUM_SETS = 4;
+const constexpr size_t HOTFIXES_PER_SET = 2000;
+// Every set changes one in this many hotfixes, the rest get reused from whichever set came before
+const constexpr size_t CHANGED_HOTFIX_INTERVAL = 5;
+const constexpr size_t NUM_PASSES = 3;
+const constexpr size_t NUM_NEWS_CALLS = 200;
+// The game's original parameters, one of which is also referenced from elsewhere
+const constexpr size_t NUM_ORIGINAL_PARAMS = 3;
+const constexpr auto BACKGROUND_TIMEOUT = std::chrono::seconds{10};
+
+#pragma region Fake Game Objects
+
+// The value vf tables are only ever compared, they just need unique addresses
+char json_value_string_vf_table;
+char json_value_array_vf_table;
+char json_value_object_vf_table;
+
+// The game's json objects aren't thread safe, so may only ever be destroyed on the thread the
+//  hooks run on
+std::thread::id game_thread;
+std::atomic<bool> destroyed_off_thread = false;
+
+void destroy_json_object(FJsonObject* obj);
+
+/**
+ * @brief Destroys a json value, like it's virtual destructor would.
+ *
+ * @param value The value to destroy.
+ */
+void destroy_json_value(FJsonValue* value) {
+    if (std::this_thread::get_id() != game_thread) {
+        destroyed_off_thread = true;
+    }
+    switch (value->type) {
+        case EJson::STRING:
+            u_free(reinterpret_cast<FJsonValueString*>(value)->str.data);
+            break;
+        case EJson::ARRAY: {
+            auto arr = reinterpret_cast<FJsonValueArray*>(value);
+            for (uint32_t i = 0; i < arr->entries.count; i++) {
+                arr->entries.data[i].reset();
+            }
+            u_free(arr->entries.data);
+            break;
+        }
+        case EJson::OBJECT:
+            reinterpret_cast<FJsonValueObject*>(value)->value.reset();
+            break;
+        default:
+            throw std::runtime_error("Tried to destroy unexpected json type");
+    }
+    u_free(value);
+}
+
+/**
+ * @brief Destroys a json object, like it's destructor would.
+ *
+ * @param obj The object to destroy.
+ */
+void destroy_json_object(FJsonObject* obj) {
+    for (uint32_t i = 0; i < obj->entries.count; i++) {
+        u_free(obj->entries.data[i].key.data);
+        obj->entries.data[i].value.reset();
+    }
+    u_free(obj->entries.data);
+    u_free(obj->allocation_flags.data.secondary_data);
+    u_free(obj->hash.secondary_data);
+    u_free(obj);
+}
+
+// Reference controller vf tables, laid out like unreal's: `DestroyObject`, then the scalar deleting
+//  destructor
+void* delete_controller(FReferenceControllerBase* self, uint32_t flags) {
+    if ((flags & 1) != 0) {
+        u_free(self);
+    }
+    return self;
+}
+const std::array<void*, 2> SHARED_PTR_JSON_VALUE_VF_TABLE{
+    reinterpret_cast<void*>(+[](FReferenceControllerBase* self) {
+        destroy_json_value(reinterpret_cast<FJsonValue*>(self->obj));
+    }),
+    reinterpret_cast<void*>(&delete_controller),
+};
+const std::array<void*, 2> SHARED_PTR_JSON_OBJECT_VF_TABLE{
+    reinterpret_cast<void*>(+[](FReferenceControllerBase* self) {
+        destroy_json_object(reinterpret_cast<FJsonObject*>(self->obj));
+    }),
+    reinterpret_cast<void*>(&delete_controller),
+};
+
+/**
+ * @brief Struct holding the game's original parameters in a discovery response, which should get
+ *        replaced.
+ */
+struct OriginalParams {
+    /// The parameter array, which the hook fills with our own.
+    FJsonValueArray* params;
+    /// An extra reference to one of the original parameters, held from somewhere else.
+    TSharedPtr<FJsonValue> shared;
+};
+
+/**
+ * @brief Creates a discovery response, the same shape as the game's.
+ *
+ * @param original If not null, adds a micropatch service, and fills this in with it's parameters.
+ * @return The root json object.
+ */
+FJsonObject* create_discovery(OriginalParams* original) {
+    auto other = create_json_object<2>({{
+        {L"configuration_group", create_json_string(L"grp")},
+        {L"service_name", create_json_string(L"Other")},
+    }});
+    if (original == nullptr) {
+        return create_json_object<1>({{
+            {L"services", create_json_array<1>({{create_json_value_object(other)}})},
+        }});
+    }
+
+    std::array<FJsonValue*, NUM_ORIGINAL_PARAMS> entries{};
+    for (auto& entry : entries) {
+        entry = create_json_value_object(create_json_object<2>({{
+            {L"key", create_json_string(L"OriginalKey")},
+            {L"value", create_json_string(L"OriginalValue")},
+        }}));
+    }
+    original->params = create_json_array<NUM_ORIGINAL_PARAMS>(entries);
+
+    original->shared = original->params->entries.data[1];
+    original->shared.ref_controller->ref_count++;
+
+    auto micropatch = create_json_object<3>({{
+        {L"configuration_group", create_json_string(L"grp")},
+        {L"service_name", create_json_string(L"Micropatch")},
+        {L"parameters", original->params},
+    }});
+    return create_json_object<1>({{
+        {L"services", create_json_array<2>({{create_json_value_object(other),
+                                              create_json_value_object(micropatch)}})},
+    }});
+}
+
+#pragma endregion
+
+/**
+ * @brief Creates a set of hotfixes, which shares most of it's entries with the other sets.
+ *
+ * @param idx The index of the set.
+ * @return The set.
+ */
+std::shared_ptr<const hfdat::LoadedHotfixes> create_set(size_t idx) {
+    std::vector<std::pair<std::wstring, std::wstring>> strings;
+    size_t num_chars = 0;
+    for (size_t i = 0; i < HOTFIXES_PER_SET; i++) {
+        auto key = std::format(L"SparkPatchEntry{}", i);
+        auto value = std::format(L"(1,1,0,),/Game/Some/Path.Path,Attr,0,,{}", i);
+        if (i % CHANGED_HOTFIX_INTERVAL == idx % CHANGED_HOTFIX_INTERVAL) {
+            value += std::format(L"_set{}", idx);
+        }
+        num_chars += key.size() + value.size();
+        strings.emplace_back(std::move(key), std::move(value));
+    }
+
+    hfdat::HotfixSet hotfixes{strings.size(), num_chars};
+    for (const auto& [key, value] : strings) {
+        hotfixes.push_back(key.data(), key.size(), value.data(), value.size());
+    }
+    hotfixes.shrink_to_fit();
+
+    return std::make_shared<const hfdat::LoadedHotfixes>(std::format("set {}", idx), false,
+                                                         std::move(hotfixes));
+}
+
+/**
+ * @brief Checks that the injected parameters match a set of hotfixes.
+ *
+ * @param params The injected parameters.
+ * @param hotfixes The set they should match.
+ */
+void check_injected(const FJsonValueArray* params, const hfdat::HotfixSet& hotfixes) {
+    test::check(params->count() == hotfixes.size(), "injected every hotfix");
+    if (params->count() != hotfixes.size()) {
+        return;
+    }
+
+    auto content_hash = crc32_z(0, nullptr, 0);
+    bool matches = true;
+    for (uint32_t i = 0; i < params->count(); i++) {
+        auto entry = params->find<FJsonValueObject>(i);
+        auto key = entry == nullptr ? nullptr : entry->to_obj()->find<FJsonValueString>(L"key");
+        auto value = entry == nullptr ? nullptr : entry->to_obj()->find<FJsonValueString>(L"value");
+        if (key == nullptr || value == nullptr || key->to_wstr() != hotfixes.key(i).to_wstr()
+            || value->to_wstr() != hotfixes.value(i).to_wstr()
+            || params->entries.data[i].ref_controller->ref_count < 1) {
+            matches = false;
+            break;
+        }
+        for (const auto* str : {&key->str, &value->str}) {
+            content_hash = crc32_z(content_hash, reinterpret_cast<const Bytef*>(str->data),
+                                   str->count * sizeof(wchar_t));
+        }
+    }
+    test::check(matches, "injected hotfixes match the set");
+    test::check(predict_hotfix_hash((uint32_t)content_hash) == running_hotfix_hash,
+                "predicted hash matches the injected hotfixes");
+}
+
+/**
+ * @brief Waits for the background threads to free everything they're going to.
+ *
+ * @param expected The amount of live allocations to wait for.
+ * @return True if the live allocations reached the expected amount.
+ */
+bool wait_for_live_allocations(int64_t expected) {
+    auto deadline = std::chrono::steady_clock::now() + BACKGROUND_TIMEOUT;
+    while (test::live_allocations != expected) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(void) {
+    set_allocator(test::COUNTING_ALLOCATOR);
+    game_thread = std::this_thread::get_id();
+
+    vf_table.json_value_string = &json_value_string_vf_table;
+    vf_table.json_value_array = &json_value_array_vf_table;
+    vf_table.json_value_object = &json_value_object_vf_table;
+    vf_table.shared_ptr_json_value = (void*)SHARED_PTR_JSON_VALUE_VF_TABLE.data();
+    vf_table.shared_ptr_json_object = (void*)SHARED_PTR_JSON_OBJECT_VF_TABLE.data();
+
+    std::vector<std::shared_ptr<const hfdat::LoadedHotfixes>> sets;
+    for (size_t i = 0; i < NUM_SETS; i++) {
+        sets.push_back(create_set(i));
+    }
+
+    // The first discovery call has no micropatch service, and just starts preparing parameters
+    auto first = create_discovery(nullptr);
+    handle_discovery_from_json(&first);
+    destroy_json_object(first);
+
+    // The gui calls this every frame, make sure it's never able to start a build part way through
+    //  handing over the last one
+    std::atomic<bool> stop_gui = false;
+    std::thread gui{[&stop_gui]() {
+        while (!stop_gui) {
+            prepare_parameters();
+        }
+    }};
+
+    auto run_discovery = [](const hfdat::HotfixSet& expected) {
+        // The game verifies twice in a row, without releasing the last response in between
+        std::array<FJsonObject*, 2> responses{};
+        std::array<OriginalParams, 2> original{};
+        for (size_t i = 0; i < responses.size(); i++) {
+            responses[i] = create_discovery(&original[i]);
+            handle_discovery_from_json(&responses[i]);
+            check_injected(original[i].params, expected);
+        }
+        for (size_t i = 0; i < responses.size(); i++) {
+            destroy_json_object(responses[i]);
+            test::check(original[i].shared.ref_controller->ref_count == 1
+                            && original[i].shared.obj->type == EJson::OBJECT,
+                        "externally referenced parameter survives being replaced");
+            original[i].shared.reset();
+        }
+    };
+
+    for (size_t pass = 0; pass < NUM_PASSES; pass++) {
+        for (const auto& set : sets) {
+            hfdat::set_loaded_hotfixes(set);
+            run_discovery(set->hotfixes);
+        }
+    }
+
+    // After switching to an empty set, nothing's left to reuse, so everything should get freed
+    auto empty = std::make_shared<const hfdat::LoadedHotfixes>("empty", false, hfdat::HotfixSet{});
+    hfdat::set_loaded_hotfixes(empty);
+    run_discovery(empty->hotfixes);
+
+    stop_gui = true;
+    gui.join();
+    test::check(wait_for_live_allocations(0), "every parameter gets freed");
+    test::check(!destroyed_off_thread, "game objects are only destroyed on the game's thread");
+
+    for (size_t i = 0; i < NUM_NEWS_CALLS; i++) {
+        std::array<FJsonValue*, 4> articles{};
+        for (auto& article : articles) {
+            article = create_json_value_object(
+                create_json_object<1>({{{L"contents", create_json_string(L"Article")}}}));
+        }
+        auto news = create_json_object<1>({{{L"data", create_json_array<4>(articles)}}});
+        handle_news_from_json(&news);
+        destroy_json_object(news);
+    }
+    test::check(test::live_allocations == 0, "news articles get freed");
+
+    set_allocator(get_stand_in_allocator());
+    return test::exit_code();
+}
@@ -0,0 +1,75 @@
+#ifndef HOTFIXES_TEST_UTILS_H
+#define HOTFIXES_TEST_UTILS_H
+
+#include "pch.h"
+
+#include "hotfixes/hooks.h"
+
+namespace dhf::test {
+
+/// How many checks have failed so far.
+inline int failures = 0;
+
+/**
+ * @brief Checks a condition, logging it and counting it as a failure if it doesn't hold.
+ *
+ * @param condition The condition to check.
+ * @param what A description of what was being checked.
+ */
+inline void check(bool condition, std::string_view what) {
+    if (!condition) {
+        failures++;
+        std::cerr << "[dhf] Check failed: " << what << "\n";
+    }
+}
+
+/**
+ * @brief Gets the exit code to return from a test's main.
+ *
+ * @return 0 if every check passed, 1 otherwise.
+ */
+inline int exit_code(void) {
+    return failures == 0 ? 0 : 1;
+}
+
+/// How many allocations made through the counting allocator are still live.
+inline std::atomic<int64_t> live_allocations = 0;
+/// If set, the next allocation made through the counting allocator fails.
+inline std::atomic<bool> fail_next_allocation = false;
+
+// New memory gets filled with this, so anything relying on it being zeroed shows up
+const constexpr uint8_t GARBAGE_BYTE = 0xCD;
+
+/**
+ * @brief Allocator which wraps the stand-in one, counting how many allocations are still live.
+ */
+inline const hotfixes::Allocator COUNTING_ALLOCATOR{
+    [](size_t len) -> void* {
+        if (fail_next_allocation.exchange(false)) {
+            return nullptr;
+        }
+        auto ret = hotfixes::get_stand_in_allocator().allocate(len);
+        if (ret != nullptr) {
+            live_allocations++;
+            memset(ret, GARBAGE_BYTE, len);
+        }
+        return ret;
+    },
+    [](void* original, size_t len) -> void* {
+        auto ret = hotfixes::get_stand_in_allocator().reallocate(original, len);
+        if (original == nullptr && ret != nullptr) {
+            live_allocations++;
+        }
+        return ret;
+    },
+    [](void* data) {
+        if (data != nullptr) {
+            live_allocations--;
+        }
+        hotfixes::get_stand_in_allocator().deallocate(data);
+    },
+};
+
+}  // namespace dhf::test
+
+#endif /* HOTFIXES_TEST_UTILS_H */
@@ -1,7 +1,7 @@
 #include "pch.h"
 
 #include "gui/gui.h"
-#include "hfdat.h"
+#include "hfdat/hfdat.h"
 #include "hotfixes/hooks.h"
 #include "settings.h"
 #include "time_travel.h"
@@ -2,7 +2,7 @@
 
 #include "gui/gui.h"
 #include "gui/hook.h"
-#include "hfdat.h"
+#include "hfdat/hfdat.h"
 #include "hotfixes/processing.h"
 #include "imgui.h"
 #include "settings.h"
@@ -110,7 +110,12 @@ const std::vector<std::string> DEFAULT_HOTFIX_LIST_ENTRIES{
 const constexpr auto NO_HOTFIXES_IDX = -1;
 const constexpr auto CURRENT_HOTFIXES_IDX = -2;
 
+const constexpr size_t BYTES_IN_KIB = 1024;
+const constexpr size_t BYTES_IN_MIB = 1024ULL * 1024;
+const constexpr auto MAX_CACHE_BUDGET_MIB = 1024;
+
 int selected_hotfix_idx = CURRENT_HOTFIXES_IDX;
+std::shared_ptr<const hfdat::AsyncLoad> current_load = nullptr;
 
 /**
  * @brief Get the display name of a hotfix.
@@ -142,7 +147,18 @@ void update_selected_hotfix(int idx) {
                                        : (idx == CURRENT_HOTFIXES_IDX ? hfdat::LoadType::CURRENT
                                                                       : hfdat::LoadType::FILE);
 
-    hfdat::load_new_hotfixes(name, type);
+    current_load = hfdat::load_new_hotfixes_async(name, type);
+}
+
+/**
+ * @brief Checks on the current hotfix load, applying it once it's finished.
+ */
+void update_current_load(void) {
+    hfdat::update_pending_load();
+    hotfixes::prepare_parameters();
+    if (current_load != nullptr && current_load->finished) {
+        current_load = nullptr;
+    }
 }
 
 #pragma endregion
@@ -223,6 +239,17 @@ std::string b64_encode(const uint8_t* data, size_t len) {
     return encoded.str();
 }
 
+/**
+ * @brief Gets the colour a hotfix hash gets displayed in.
+ *
+ * @param hash The hash.
+ * @return The hash's colour.
+ */
+const ImVec4& get_hash_colour(uint64_t hash) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    return ALL_COLOURS[hash % IM_ARRAYSIZE(ALL_COLOURS)];
+}
+
 /**
  * @brief Draws a window displaying the status of all our edits.
  */
@@ -251,12 +278,17 @@ void draw_status_window(void) {
                                  sizeof(hotfixes::running_hotfix_hash));
     }
 
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
-    auto& hotfix_colour = ALL_COLOURS[hotfixes::running_hotfix_hash % IM_ARRAYSIZE(ALL_COLOURS)];
-
-    ImGui::TextColored(hotfix_colour, "%s", hotfix_hash.c_str());
+    ImGui::TextColored(get_hash_colour(hotfixes::running_hotfix_hash), "%s", hotfix_hash.c_str());
     ImGui::TextDisabled("%s", get_hotfix_display_name(hotfixes::running_hotfix_name));
 
+    auto cache_stats = hfdat::get_cache_stats();
+    if (cache_stats.hits + cache_stats.misses > 0) {
+        ImGui::TextDisabled("%s", std::format("Cache: {} hits, {} misses, {:.1f} MiB",
+                                              cache_stats.hits, cache_stats.misses,
+                                              (double)cache_stats.resident_bytes / BYTES_IN_MIB)
+                                      .c_str());
+    }
+
     if (settings::is_bl3) {
         auto injected_time = std::chrono::system_clock::now() + time_travel::time_offset;
         ImGui::TextDisabled("%s", std::format("{:%F %R}", injected_time).c_str());
@@ -307,6 +339,127 @@ void draw_time_travel_section(void) {
     }
 }
 
+/**
+ * @brief The columns of the hotfix list, doubling as their sort ids.
+ */
+enum class HotfixColumn : ImGuiID {
+    NAME,
+    RELEASED,
+    COUNT,
+    SIZE,
+};
+
+/**
+ * @brief Sorts the hotfix list by the given column.
+ * @note Sets which compare equal, or which are missing the info, stay in archive order.
+ *
+ * @param order The indexes of each set, which get sorted in place.
+ * @param specs The sort specs to use.
+ */
+void sort_hotfix_list(std::vector<int>& order, const ImGuiTableSortSpecs& specs) {
+    order.resize(hfdat::hotfix_names.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (specs.SpecsCount == 0) {
+        return;
+    }
+
+    auto column = (HotfixColumn)specs.Specs[0].ColumnUserID;
+    auto ascending = specs.Specs[0].SortDirection == ImGuiSortDirection_Ascending;
+
+    std::ranges::stable_sort(order, [&](int lhs, int rhs) {
+        const auto& lhs_info = hfdat::hotfix_info[lhs];
+        const auto& rhs_info = hfdat::hotfix_info[rhs];
+
+        std::strong_ordering cmp = std::strong_ordering::equal;
+        switch (column) {
+            case HotfixColumn::RELEASED:
+                cmp = lhs_info.released <=> rhs_info.released;
+                break;
+            case HotfixColumn::COUNT:
+                cmp = lhs_info.num_hotfixes <=> rhs_info.num_hotfixes;
+                break;
+            case HotfixColumn::SIZE:
+                cmp = lhs_info.num_chars <=> rhs_info.num_chars;
+                break;
+            case HotfixColumn::NAME:
+            default:
+                // The full names include the ordering chars, so this sorts in archive order
+                cmp = hfdat::hotfix_names[lhs] <=> hfdat::hotfix_names[rhs];
+                break;
+        }
+        return ascending ? cmp < 0 : cmp > 0;
+    });
+}
+
+/**
+ * @brief Draws a tooltip holding all the info the catalog has about a set of hotfixes.
+ *
+ * @param name The display name of the set.
+ * @param info The set's info.
+ */
+void draw_hotfix_tooltip(const char* name, const hfdat::SetInfo& info) {
+    ImGui::BeginTooltip();
+    ImGui::Text("%s", name);
+
+    if (info.released.has_value()) {
+        ImGui::TextDisabled("%s", std::format("Released {:%F %R} UTC", *info.released).c_str());
+    }
+    if (info.num_hotfixes.has_value()) {
+        ImGui::TextDisabled("%s", std::format("{} hotfixes", *info.num_hotfixes).c_str());
+    }
+    if (info.num_chars.has_value()) {
+        auto text_kib = *info.num_chars * sizeof(wchar_t) / BYTES_IN_KIB;
+        ImGui::TextDisabled("%s", std::format("{} KiB of text", text_kib).c_str());
+    }
+    if (info.stored_size.has_value()) {
+        ImGui::TextDisabled(
+            "%s", std::format("{} KiB in the hfdat", *info.stored_size / BYTES_IN_KIB).c_str());
+    }
+    if (info.content_hash.has_value()) {
+        auto hash = hotfixes::predict_hotfix_hash(*info.content_hash);
+        auto encoded = b64_encode(reinterpret_cast<const uint8_t*>(&hash), sizeof(hash));
+        ImGui::TextColored(get_hash_colour(hash), "%s", encoded.c_str());
+    }
+
+    ImGui::EndTooltip();
+}
+
+/**
+ * @brief Draws a row of the hotfix list.
+ *
+ * @param name The display name of the set.
+ * @param selected True if the row is currently highlighted.
+ * @param info The set's info, or null if it's one of the default entries.
+ * @return True if the row was clicked.
+ */
+bool draw_hotfix_row(const char* name, bool selected, const hfdat::SetInfo* info) {
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    auto clicked = ImGui::Selectable(name, selected,
+                                     ImGuiSelectableFlags_AllowDoubleClick
+                                         | ImGuiSelectableFlags_SpanAllColumns);
+    if (info == nullptr) {
+        return clicked;
+    }
+
+    if (ImGui::IsItemHovered()) {
+        draw_hotfix_tooltip(name, *info);
+    }
+
+    if (ImGui::TableNextColumn() && info->released.has_value()) {
+        ImGui::Text("%s", std::format("{:%F}", *info->released).c_str());
+    }
+    if (ImGui::TableNextColumn() && info->num_hotfixes.has_value()) {
+        ImGui::Text("%s", std::format("{}", *info->num_hotfixes).c_str());
+    }
+    if (ImGui::TableNextColumn() && info->num_chars.has_value()) {
+        auto text_kib = *info->num_chars * sizeof(wchar_t) / BYTES_IN_KIB;
+        ImGui::Text("%s", std::format("{}", text_kib).c_str());
+    }
+
+    return clicked;
+}
+
 /**
  * @brief Draws a section of a window holding all the settings to do with hotfixes.
  */
@@ -324,7 +477,21 @@ void draw_hotfix_section(void) {
                     - ImGui::GetStyle().ItemSpacing.x);
     ImGui::TextDisabled("%s", hfdat::hfdat_name.c_str());
 
-    ImGui::Text("%s", get_hotfix_display_name(hfdat::loaded_hotfixes_name));
+    ImGui::Text("%s", get_hotfix_display_name(hfdat::get_loaded_hotfixes()->name));
+
+    if (current_load != nullptr) {
+        ImGui::ProgressBar(current_load->progress, {-FLT_MIN, 0},
+                           get_hotfix_display_name(current_load->name));
+    }
+
+    static int cache_budget_mib = (int)(hfdat::get_cache_stats().budget_bytes / BYTES_IN_MIB);
+    ImGui::AlignTextToFramePadding();
+    ImGui::Text("Cache (MiB)");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    if (ImGui::SliderInt("##cache budget", &cache_budget_mib, 0, MAX_CACHE_BUDGET_MIB)) {
+        hfdat::set_cache_budget((size_t)cache_budget_mib * BYTES_IN_MIB);
+    }
 
     static ImGuiTextFilter filter;
     ImGui::AlignTextToFramePadding();
@@ -332,26 +499,57 @@ void draw_hotfix_section(void) {
     ImGui::SameLine();
     filter.Draw("##filter", -FLT_MIN);
 
-    if (ImGui::BeginListBox("##hotfixlist", {-FLT_MIN, -FLT_MIN})) {
+    const constexpr auto table_flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_Hideable
+                                       | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg
+                                       | ImGuiTableFlags_BordersOuter;
+    const constexpr auto num_columns = 4;
+
+    if (ImGui::BeginTable("##hotfixlist", num_columns, table_flags, {-FLT_MIN, -FLT_MIN})) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Name",
+                                ImGuiTableColumnFlags_WidthStretch | ImGuiTableColumnFlags_NoHide
+                                    | ImGuiTableColumnFlags_DefaultSort,
+                                0.0F, (ImGuiID)HotfixColumn::NAME);
+        ImGui::TableSetupColumn("Released", ImGuiTableColumnFlags_WidthFixed, 0.0F,
+                                (ImGuiID)HotfixColumn::RELEASED);
+        ImGui::TableSetupColumn("Hotfixes",
+                                ImGuiTableColumnFlags_WidthFixed
+                                    | ImGuiTableColumnFlags_PreferSortDescending,
+                                0.0F, (ImGuiID)HotfixColumn::COUNT);
+        ImGui::TableSetupColumn("KiB",
+                                ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_DefaultHide
+                                    | ImGuiTableColumnFlags_PreferSortDescending,
+                                0.0F, (ImGuiID)HotfixColumn::SIZE);
+        ImGui::TableHeadersRow();
+
+        // Sorting only ever uses the catalog, so doesn't need to touch any of the sets themselves
+        static std::vector<int> sorted_hotfix_idxs;
+        auto* sort_specs = ImGui::TableGetSortSpecs();
+        if (sort_specs != nullptr
+            && (sort_specs->SpecsDirty
+                || sorted_hotfix_idxs.size() != hfdat::hotfix_names.size())) {
+            sort_hotfix_list(sorted_hotfix_idxs, *sort_specs);
+            sort_specs->SpecsDirty = false;
+        }
+
         bool double_click = false;
 
+        // The default entries always stay at the top
         for (auto i = 0; (size_t)i < DEFAULT_HOTFIX_LIST_ENTRIES.size(); i++) {
             auto name = get_hotfix_display_name(DEFAULT_HOTFIX_LIST_ENTRIES[i]);
             auto storage_idx = -1 - i;
             if (filter.PassFilter(name)) {
-                if (ImGui::Selectable(name, highlighted_hotfix_idx == storage_idx,
-                                      ImGuiSelectableFlags_AllowDoubleClick)) {
+                if (draw_hotfix_row(name, highlighted_hotfix_idx == storage_idx, nullptr)) {
                     highlighted_hotfix_idx = storage_idx;
                     double_click = ImGui::IsMouseDoubleClicked(0);
                 }
             }
         }
 
-        for (auto i = 0; (size_t)i < hfdat::hotfix_names.size(); i++) {
+        for (auto i : sorted_hotfix_idxs) {
             auto name = get_hotfix_display_name(hfdat::hotfix_names[i]);
             if (filter.PassFilter(name)) {
-                if (ImGui::Selectable(name, highlighted_hotfix_idx == i,
-                                      ImGuiSelectableFlags_AllowDoubleClick)) {
+                if (draw_hotfix_row(name, highlighted_hotfix_idx == i, &hfdat::hotfix_info[i])) {
                     highlighted_hotfix_idx = i;
                     double_click = ImGui::IsMouseDoubleClicked(0);
                 }
@@ -362,7 +560,7 @@ void draw_hotfix_section(void) {
             update_selected_hotfix(highlighted_hotfix_idx);
         }
 
-        ImGui::EndListBox();
+        ImGui::EndTable();
     }
 }
 
@@ -372,6 +570,7 @@ void render(void) {
     const constexpr auto default_settings_window_height_lines = 30;
     const constexpr auto default_settings_window_width = 320;
 
+    update_current_load();
     draw_status_window();
 
     if (!settings_showing) {
@@ -395,9 +594,10 @@ void render(void) {
 }
 
 void init(void) {
-    hook();
+    // Select hotfixes before hooking so we're not racing the render thread for the current load
     set_event_time_to_now();
     update_selected_hotfix(CURRENT_HOTFIXES_IDX);
+    hook();
 }
 
 bool is_showing(void) {
@@ -0,0 +1,629 @@
+#include "pch.h"
+
+#include "hfdat/decode.h"
+#include "hfdat/hfdat.h"
+
+namespace dhf::hfdat {
+
+namespace {
+
+// How often to report progress while parsing
+const constexpr auto PROGRESS_INTERVAL = 0x400;
+
+const constexpr uint32_t VARINT_BITS = 7;
+const constexpr uint8_t VARINT_VALUE_MASK = 0x7F;
+const constexpr uint8_t VARINT_CONTINUE = 0x80;
+
+// Room for the longest number a regular columnar key may hold
+const constexpr size_t MAX_KEY_DIGITS = std::numeric_limits<uint32_t>::digits10 + 1;
+
+const constexpr uint32_t CATALOG_MAGIC = 0x4D464844;  // "DHFM"
+// The size of the fields we know about, newer archives may add more after them
+const constexpr size_t CATALOG_ENTRY_SIZE = (2 * sizeof(uint64_t)) + sizeof(uint32_t);
+// Mods don't have a release date, these get stored as a time of 0
+const constexpr int64_t CATALOG_UNKNOWN_TIME = 0;
+
+/**
+ * @brief Helper to read values out of a decompressed block, with bounds checking.
+ */
+class BlockReader {
+   public:
+    BlockReader(const uint8_t* data, size_t size, PipelineBuffer* pipeline = nullptr)
+        : data(data), size(size), pipeline(pipeline) {}
+
+    /**
+     * @brief Reads a uint32 from the current position.
+     *
+     * @return The read value.
+     */
+    uint32_t read_u32(void) {
+        uint32_t value{};
+        this->check_remaining(sizeof(value));
+        memcpy(&value, &this->data[this->pos], sizeof(value));
+        this->pos += sizeof(value);
+        return value;
+    }
+
+    /**
+     * @brief Reads a uint64 from the current position.
+     *
+     * @return The read value.
+     */
+    uint64_t read_u64(void) {
+        uint64_t value{};
+        this->check_remaining(sizeof(value));
+        memcpy(&value, &this->data[this->pos], sizeof(value));
+        this->pos += sizeof(value);
+        return value;
+    }
+
+    /**
+     * @brief Reads a length prefixed string from the current position.
+     *
+     * @return A pointer to the (possibly unaligned) characters, and the length of the string.
+     */
+    std::pair<const uint8_t*, uint32_t> read_str(void) {
+        auto len = this->read_u32();
+        this->check_remaining((size_t)len * sizeof(wchar_t));
+        auto str = &this->data[this->pos];
+        this->pos += (size_t)len * sizeof(wchar_t);
+        return {str, len};
+    }
+
+    /**
+     * @brief Reads an unsigned LEB128 varint from the current position.
+     *
+     * @return The read value.
+     */
+    uint64_t read_varint(void) {
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift < std::numeric_limits<uint64_t>::digits;
+             shift += VARINT_BITS) {
+            this->check_remaining(1);
+            auto byte = this->data[this->pos++];
+            auto bits = (uint64_t)(byte & VARINT_VALUE_MASK);
+            // On the last byte, only the bits which still fit in the value may be set
+            if (shift > std::numeric_limits<uint64_t>::digits - VARINT_BITS
+                && (bits >> (std::numeric_limits<uint64_t>::digits - shift)) != 0) {
+                throw std::runtime_error("Block has an invalid varint");
+            }
+            value |= bits << shift;
+            if ((byte & VARINT_CONTINUE) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("Block has an invalid varint");
+    }
+
+    /**
+     * @brief Reads a run of raw bytes from the current position.
+     *
+     * @param len The amount of bytes to read.
+     * @return A pointer to the bytes.
+     */
+    const uint8_t* read_bytes(size_t len) {
+        this->check_remaining(len);
+        auto bytes = &this->data[this->pos];
+        this->pos += len;
+        return bytes;
+    }
+
+    /**
+     * @brief Reads a size prefixed column from the current position.
+     *
+     * @return A new reader covering just the column.
+     */
+    BlockReader read_column(void) {
+        auto size = this->read_u32();
+        return {this->read_bytes(size), size};
+    }
+
+    /**
+     * @brief Checks that there's at least the given amount of bytes left to read.
+     * @note Throws a runtime error if there isn't.
+     *
+     * @param len The amount of bytes.
+     */
+    void check_remaining(size_t len) const {
+        if (len > this->size - this->pos) {
+            throw std::runtime_error("Block is truncated");
+        }
+        if (this->pipeline != nullptr) {
+            this->pipeline->wait_for(this->pos + len);
+        }
+    }
+
+    /**
+     * @brief Gets the amount of bytes left to read.
+     *
+     * @return The remaining bytes.
+     */
+    [[nodiscard]] size_t remaining(void) const { return this->size - this->pos; }
+
+   private:
+    const uint8_t* data;
+    size_t size;
+    PipelineBuffer* pipeline;
+    size_t pos = 0;
+};
+
+/**
+ * @brief Parses a set of hotfixes out of a block reader.
+ *
+ * @param reader The reader to parse from.
+ * @param hotfixes The set to load the hotfixes into.
+ * @param token The token to report progress and check for cancellation with.
+ * @param progress_start The progress fraction to report before anything has been parsed.
+ */
+void parse_hotfixes(BlockReader& reader,
+                    HotfixSet& hotfixes,
+                    const LoadToken& token,
+                    float progress_start) {
+    auto num_hotfixes = reader.read_u32();
+
+    // Every hotfix takes up at least two length prefixes, everything else is characters
+    auto prefixes_size = (size_t)num_hotfixes * 2 * sizeof(uint32_t);
+    reader.check_remaining(prefixes_size);
+    hotfixes = HotfixSet{num_hotfixes, (reader.remaining() - prefixes_size) / sizeof(wchar_t)};
+
+    for (uint32_t i = 0; i < num_hotfixes; i++) {
+        if (i % PROGRESS_INTERVAL == 0) {
+            token.update(i, num_hotfixes, progress_start);
+        }
+
+        auto [key, key_len] = reader.read_str();
+        auto [value, value_len] = reader.read_str();
+        hotfixes.push_back(key, key_len, value, value_len);
+    }
+
+    // Most strings narrow to Latin-1, so there's usually about half the arena left unused
+    hotfixes.shrink_to_fit();
+}
+
+/**
+ * @brief Reads the key prefix table out of a columnar set.
+ *
+ * @param column The reader over the prefix column.
+ * @return Views of each prefix's utf8 bytes.
+ */
+std::vector<std::string_view> read_key_prefixes(BlockReader& column) {
+    std::vector<std::string_view> prefixes;
+    while (column.remaining() > 0) {
+        auto len = column.read_varint();
+        prefixes.emplace_back(reinterpret_cast<const char*>(column.read_bytes((size_t)len)),
+                              (size_t)len);
+    }
+    return prefixes;
+}
+
+/**
+ * @brief Works out the largest combined length a columnar set's strings could decode to.
+ * @note Throws a runtime error if the value lengths don't fit in the suffix column.
+ *
+ * @param num_hotfixes The amount of hotfixes in the set.
+ * @param prefixes The key prefix table.
+ * @param keys_size The size of the key column.
+ * @param shared_lens A copy of the reader over the shared length column.
+ * @param suffix_lens A copy of the reader over the suffix length column.
+ * @param suffixes_size The size of the suffix column.
+ * @return The maximum combined utf8 length of all keys and values.
+ */
+uint64_t get_max_columnar_size(uint32_t num_hotfixes,
+                               const std::vector<std::string_view>& prefixes,
+                               size_t keys_size,
+                               BlockReader shared_lens,
+                               BlockReader suffix_lens,
+                               size_t suffixes_size) {
+    // Values are exact, since their lengths are stored separately from the data
+    uint64_t values_size = 0;
+    uint64_t suffixes_used = 0;
+    uint64_t last_len = 0;
+    for (uint32_t i = 0; i < num_hotfixes; i++) {
+        auto shared_len = shared_lens.read_varint();
+        auto suffix_len = suffix_lens.read_varint();
+        if (shared_len > last_len || suffix_len > suffixes_size - suffixes_used) {
+            throw std::runtime_error("Set has invalid value lengths");
+        }
+        suffixes_used += suffix_len;
+        last_len = shared_len + suffix_len;
+        values_size += last_len;
+    }
+
+    // Irregular keys are stored in full, regular ones are at most the longest prefix plus a number
+    size_t longest_prefix = 0;
+    for (const auto& prefix : prefixes) {
+        longest_prefix = std::max(longest_prefix, prefix.size());
+    }
+    return values_size + keys_size
+           + ((uint64_t)num_hotfixes * (longest_prefix + MAX_KEY_DIGITS));
+}
+
+/**
+ * @brief Decodes the next key out of a columnar set's key column.
+ *
+ * @param keys The reader over the key column.
+ * @param prefixes The key prefix table.
+ * @param key A buffer to build regular keys in.
+ * @param last_number The number on the end of the last regular key, updated if the new key is.
+ * @return A view of the key's utf8 bytes, valid until the next call.
+ */
+std::string_view read_columnar_key(BlockReader& keys,
+                                   const std::vector<std::string_view>& prefixes,
+                                   std::string& key,
+                                   int64_t& last_number) {
+    // 0 escapes an irregular key, stored in full
+    auto code = keys.read_varint();
+    if (code == 0) {
+        auto len = keys.read_varint();
+        return {reinterpret_cast<const char*>(keys.read_bytes((size_t)len)), (size_t)len};
+    }
+    if (prefixes.empty()) {
+        throw std::runtime_error("Key refers to a missing prefix");
+    }
+
+    // Otherwise it's the prefix index, plus a zigzag encoded delta from the last number, minus one
+    code--;
+    auto prefix = prefixes[code % prefixes.size()];
+    auto zigzag = code / prefixes.size();
+    auto delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+
+    // Check the delta before applying it, a garbage one could overflow the addition
+    if (delta < -(last_number + 1)
+        || delta > (int64_t)std::numeric_limits<uint32_t>::max() - last_number - 1) {
+        throw std::runtime_error("Key number is out of range");
+    }
+    auto number = last_number + 1 + delta;
+    last_number = number;
+
+    std::array<char, MAX_KEY_DIGITS> digits{};
+    auto* end = std::to_chars(digits.data(), digits.data() + digits.size(), number).ptr;
+    key.assign(prefix);
+    key.append(digits.data(), end);
+    return key;
+}
+
+/**
+ * @brief Gets the throughput of a stage, in MiB/s.
+ *
+ * @param size The amount of bytes processed.
+ * @param duration How long the stage was busy for.
+ * @return The throughput.
+ */
+double throughput(size_t size, std::chrono::duration<double> duration) {
+    if (duration.count() <= 0) {
+        return 0;
+    }
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    return (double)size / (1024 * 1024) / duration.count();
+}
+
+}  // namespace
+
+PipelineBuffer::PipelineBuffer(size_t size)
+    : buffer(std::make_unique_for_overwrite<uint8_t[]>(size)), buffer_size(size) {}
+
+uint8_t* PipelineBuffer::data(void) {
+    return this->buffer.get();
+}
+
+size_t PipelineBuffer::size(void) const {
+    return this->buffer_size;
+}
+
+void PipelineBuffer::publish(size_t new_filled) {
+    // Only we ever increase it, so it either still holds what we last set, or it was aborted
+    auto expected = this->last_published;
+    if (!this->filled.compare_exchange_strong(expected, new_filled, std::memory_order_release)) {
+        throw LoadCancelled{};
+    }
+    this->last_published = new_filled;
+    this->filled.notify_one();
+}
+
+void PipelineBuffer::finish(void) {
+    if (this->last_published != this->buffer_size) {
+        throw std::runtime_error("Set is smaller than expected");
+    }
+}
+
+void PipelineBuffer::wait_for(size_t required) {
+    if (required <= this->known_filled) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        auto current = this->filled.load(std::memory_order_acquire);
+        if (current == ABORTED) {
+            throw std::runtime_error("Decompression stopped early");
+        }
+        if (current >= required) {
+            this->known_filled = current;
+            break;
+        }
+        this->filled.wait(current, std::memory_order_acquire);
+    }
+    this->waiting += std::chrono::steady_clock::now() - start;
+}
+
+void PipelineBuffer::abort(void) {
+    this->filled.store(ABORTED, std::memory_order_release);
+    this->filled.notify_all();
+}
+
+std::chrono::steady_clock::duration PipelineBuffer::time_waiting(void) const {
+    return this->waiting;
+}
+
+void parse_hotfixes(const uint8_t* data,
+                    size_t size,
+                    HotfixSet& hotfixes,
+                    const LoadToken& token) {
+    BlockReader reader{data, size};
+    parse_hotfixes(reader, hotfixes, token, PARSE_PROGRESS_START);
+}
+
+void parse_columnar_hotfixes(const uint8_t* data,
+                             size_t size,
+                             HotfixSet& hotfixes,
+                             const LoadToken& token) {
+    BlockReader reader{data, size};
+
+    auto num_hotfixes = reader.read_u32();
+    auto total_size = reader.read_u32();
+
+    auto prefix_column = reader.read_column();
+    auto keys = reader.read_column();
+    auto shared_lens = reader.read_column();
+    auto suffix_lens = reader.read_column();
+    auto suffixes = reader.read_column();
+    if (reader.remaining() != 0) {
+        throw std::runtime_error("Set has the wrong size");
+    }
+
+    // Every hotfix takes up at least a byte in each of these
+    if (num_hotfixes > keys.remaining() || num_hotfixes > shared_lens.remaining()
+        || num_hotfixes > suffix_lens.remaining()) {
+        throw std::runtime_error("Block is truncated");
+    }
+
+    // Keys are mostly a prefix followed by an increasing number, e.g. `SparkPatchEntry123`
+    auto prefixes = read_key_prefixes(prefix_column);
+
+    // Front coding means the strings are usually larger than the block, so rather than comparing
+    //  against it, make sure the size we're about to allocate is one the columns could produce
+    if (total_size > get_max_columnar_size(num_hotfixes, prefixes, keys.remaining(), shared_lens,
+                                           suffix_lens, suffixes.remaining())) {
+        throw std::runtime_error("Set has an invalid size");
+    }
+    hotfixes = HotfixSet{num_hotfixes, total_size};
+    std::string key;
+    int64_t last_number = 0;
+
+    // Values are front coded, storing how much they share with the value before them
+    std::string value;
+
+    for (uint32_t i = 0; i < num_hotfixes; i++) {
+        if (i % PROGRESS_INTERVAL == 0) {
+            token.update(i, num_hotfixes, PARSE_PROGRESS_START);
+        }
+
+        auto key_view = read_columnar_key(keys, prefixes, key, last_number);
+
+        auto shared_len = shared_lens.read_varint();
+        auto suffix_len = suffix_lens.read_varint();
+        if (shared_len > value.size()) {
+            throw std::runtime_error("Value shares more than the length of the one before it");
+        }
+        value.resize((size_t)shared_len);
+        value.append(reinterpret_cast<const char*>(suffixes.read_bytes((size_t)suffix_len)),
+                     (size_t)suffix_len);
+
+        hotfixes.push_back_utf8(reinterpret_cast<const uint8_t*>(key_view.data()), key_view.size(),
+                                reinterpret_cast<const uint8_t*>(value.data()), value.size());
+    }
+
+    if (keys.remaining() != 0 || shared_lens.remaining() != 0 || suffix_lens.remaining() != 0
+        || suffixes.remaining() != 0) {
+        throw std::runtime_error("Set has the wrong size");
+    }
+    hotfixes.shrink_to_fit();
+}
+
+void pipeline_hotfixes(size_t size,
+                       const std::function<void(PipelineBuffer&)>& decompress,
+                       HotfixSet& hotfixes,
+                       const LoadToken& token,
+                       float progress_start) {
+    PipelineBuffer buffer{size};
+
+    std::exception_ptr decompress_error;
+    std::chrono::steady_clock::duration decompress_time{};
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread worker{[&]() {
+        try {
+            decompress(buffer);
+            buffer.finish();
+        } catch (const LoadCancelled&) {
+            // The parser stopped first, it'll report why
+        } catch (...) {
+            decompress_error = std::current_exception();
+            buffer.abort();
+        }
+        decompress_time = std::chrono::steady_clock::now() - start;
+    }};
+
+    try {
+        BlockReader reader{buffer.data(), buffer.size(), &buffer};
+        parse_hotfixes(reader, hotfixes, token, progress_start);
+    } catch (...) {
+        buffer.abort();
+        worker.join();
+        // If decompression failed, the parser only stopped since it ran out of data
+        if (decompress_error != nullptr) {
+            std::rethrow_exception(decompress_error);
+        }
+        throw;
+    }
+    worker.join();
+    if (decompress_error != nullptr) {
+        std::rethrow_exception(decompress_error);
+    }
+
+    using milliseconds = std::chrono::duration<double, std::milli>;
+    auto total_time = milliseconds{std::chrono::steady_clock::now() - start};
+    auto parse_time = total_time - milliseconds{buffer.time_waiting()};
+    std::cout << std::format(
+        "[dhf] Pipelined {} KiB: decompressed in {:.1f}ms ({:.0f} MiB/s), parsed in {:.1f}ms "
+        "({:.0f} MiB/s), {:.1f}ms total\n",
+        // NOLINTNEXTLINE(readability-magic-numbers)
+        size / 1024, milliseconds{decompress_time}.count(), throughput(size, decompress_time),
+        parse_time.count(), throughput(size, parse_time), total_time.count());
+}
+
+void parse_string_pool(const uint8_t* data,
+                       size_t size,
+                       StringPool& pool,
+                       const LoadToken& token) {
+    BlockReader reader{data, size};
+
+    auto num_strings = reader.read_u32();
+
+    auto prefixes_size = (size_t)num_strings * sizeof(uint32_t);
+    reader.check_remaining(prefixes_size);
+    pool = StringPool{num_strings, (reader.remaining() - prefixes_size) / sizeof(wchar_t)};
+
+    for (uint32_t i = 0; i < num_strings; i++) {
+        if (i % PROGRESS_INTERVAL == 0) {
+            token.update(i, num_strings, PARSE_PROGRESS_START);
+        }
+
+        auto [str, len] = reader.read_str();
+        pool.push_back(str, len);
+    }
+
+    pool.shrink_to_fit();
+}
+
+std::vector<uint32_t> parse_pooled_ids(const uint8_t* data, size_t size) {
+    BlockReader reader{data, size};
+
+    auto num_hotfixes = reader.read_u32();
+    auto ids_size = (size_t)num_hotfixes * 2 * sizeof(uint32_t);
+    if (ids_size != reader.remaining()) {
+        throw std::runtime_error("Set has the wrong size");
+    }
+
+    std::vector<uint32_t> ids((size_t)num_hotfixes * 2);
+    memcpy(ids.data(), &data[size - ids_size], ids_size);
+    return ids;
+}
+
+std::vector<uint32_t> apply_delta(const uint8_t* data,
+                                  size_t size,
+                                  const std::vector<uint32_t>& base) {
+    BlockReader reader{data, size};
+
+    auto num_hotfixes = reader.read_u32();
+
+    // Position in the base, in hotfixes
+    size_t base_pos = 0;
+    auto base_size = base.size() / 2;
+
+    // At best every base hotfix gets copied, and every remaining byte is an inserted id, so check
+    //  the count against that before trusting it with an allocation
+    if (num_hotfixes > base_size + (reader.remaining() / (2 * sizeof(uint32_t)))) {
+        throw std::runtime_error("Delta produces more hotfixes than it can hold");
+    }
+    std::vector<uint32_t> ids;
+    ids.reserve((size_t)num_hotfixes * 2);
+
+    while (reader.remaining() > 0) {
+        auto op = (DeltaOp)reader.read_u32();
+        auto count = reader.read_u32();
+
+        switch (op) {
+            case DeltaOp::COPY:
+                if (count > base_size - base_pos) {
+                    throw std::runtime_error("Delta copies past the end of the base set");
+                }
+                ids.insert(ids.end(), base.begin() + (ptrdiff_t)(base_pos * 2),
+                           base.begin() + (ptrdiff_t)((base_pos + count) * 2));
+                base_pos += count;
+                break;
+
+            case DeltaOp::SKIP:
+                if (count > base_size - base_pos) {
+                    throw std::runtime_error("Delta skips past the end of the base set");
+                }
+                base_pos += count;
+                break;
+
+            case DeltaOp::INSERT:
+                reader.check_remaining((size_t)count * 2 * sizeof(uint32_t));
+                for (uint32_t i = 0; i < count * 2; i++) {
+                    ids.push_back(reader.read_u32());
+                }
+                break;
+
+            default:
+                throw std::runtime_error("Unknown delta op " + std::to_string((uint32_t)op));
+        }
+
+        if (ids.size() > (size_t)num_hotfixes * 2) {
+            throw std::runtime_error("Delta produces more hotfixes than expected");
+        }
+    }
+
+    if (ids.size() != (size_t)num_hotfixes * 2) {
+        throw std::runtime_error("Delta produces fewer hotfixes than expected");
+    }
+    return ids;
+}
+
+void build_pooled_hotfixes(const std::vector<uint32_t>& ids,
+                           const std::shared_ptr<const StringPool>& pool,
+                           HotfixSet& hotfixes,
+                           const LoadToken& token) {
+    auto num_hotfixes = ids.size() / 2;
+    hotfixes = HotfixSet{pool, num_hotfixes};
+
+    for (size_t i = 0; i < num_hotfixes; i++) {
+        if (i % PROGRESS_INTERVAL == 0) {
+            token.update(i, num_hotfixes, PARSE_PROGRESS_START);
+        }
+        hotfixes.push_back(ids[i * 2], ids[(i * 2) + 1]);
+    }
+}
+
+void parse_catalog(const uint8_t* data, size_t size, std::vector<SetInfo>& info) {
+    // Archives written before the catalog existed end straight after the entries
+    if (size == 0) {
+        return;
+    }
+
+    BlockReader reader{data, size};
+    if (reader.read_u32() != CATALOG_MAGIC) {
+        throw std::runtime_error("Catalog has an invalid magic");
+    }
+    auto entry_size = reader.read_u32();
+    if (entry_size < CATALOG_ENTRY_SIZE) {
+        throw std::runtime_error("Catalog entries are too small");
+    }
+
+    // Only fill in the info once we know the whole catalog is valid
+    auto parsed = info;
+    for (auto& set : parsed) {
+        BlockReader entry{reader.read_bytes(entry_size), entry_size};
+        set.num_chars = entry.read_u64();
+        auto released = (int64_t)entry.read_u64();
+        if (released != CATALOG_UNKNOWN_TIME) {
+            set.released = std::chrono::sys_seconds{std::chrono::seconds{released}};
+        }
+        set.content_hash = entry.read_u32();
+    }
+    info = std::move(parsed);
+}
+
+}  // namespace dhf::hfdat
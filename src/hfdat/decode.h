@@ -0,0 +1,256 @@
+#ifndef HFDAT_DECODE_H
+#define HFDAT_DECODE_H
+
+#include "pch.h"
+
+#include "hfdat/hfdat.h"
+#include "hfdat/load_token.h"
+
+namespace dhf::hfdat {
+
+/// How much of a load's progress is taken up by decompressing, the rest is parsing.
+const constexpr auto PARSE_PROGRESS_START = 0.9F;
+
+/**
+ * @brief RAII wrapper around a zlib inflate stream.
+ */
+struct InflateStream {
+    z_stream strm{};
+
+    InflateStream(int window_bits) {
+        auto ret = inflateInit2(&this->strm, window_bits);
+        if (ret != Z_OK) {
+            throw std::runtime_error("Failed to initalize inflate: " + std::to_string(ret));
+        }
+    }
+    ~InflateStream() { inflateEnd(&this->strm); }
+
+    InflateStream(const InflateStream&) = delete;
+    InflateStream(InflateStream&&) = delete;
+    InflateStream& operator=(const InflateStream&) = delete;
+    InflateStream& operator=(InflateStream&&) = delete;
+
+    /**
+     * @brief Runs inflate, and throws on any unrecoverable errors.
+     *
+     * @param flush The flush mode to use.
+     * @return The return code.
+     */
+    int inflate(int flush) {
+        auto ret = ::inflate(&this->strm, flush);
+        if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR
+            || ret == Z_STREAM_ERROR) {
+            throw std::runtime_error("Failed to inflate: " + std::to_string(ret));
+        }
+        return ret;
+    }
+};
+
+/**
+ * @brief Parses a decompressed set of hotfixes.
+ * @note Throws a runtime error if the data is malformed.
+ *
+ * @param data The decompressed set.
+ * @param size The size of the set.
+ * @param hotfixes The set to load the hotfixes into.
+ * @param token The token to report progress and check for cancellation with.
+ */
+void parse_hotfixes(const uint8_t* data,
+                    size_t size,
+                    HotfixSet& hotfixes,
+                    const LoadToken& token = {});
+
+/**
+ * @brief Parses a decompressed set of hotfixes stored in the columnar layout.
+ * @note Throws a runtime error if the data is malformed.
+ *
+ * @param data The decompressed set.
+ * @param size The size of the set.
+ * @param hotfixes The set to load the hotfixes into.
+ * @param token The token to report progress and check for cancellation with.
+ */
+void parse_columnar_hotfixes(const uint8_t* data,
+                             size_t size,
+                             HotfixSet& hotfixes,
+                             const LoadToken& token = {});
+
+/// Sets smaller than this aren't worth spinning up a second thread to decompress.
+const constexpr size_t PIPELINE_MIN_SIZE = 0x100000;
+
+/**
+ * @brief A buffer which one thread decompresses into, while another parses out of it.
+ * @note The only state shared between the two is the amount of bytes filled so far, which the
+ *       decompressing thread publishes after each chunk, and the parsing thread waits on.
+ */
+class PipelineBuffer {
+   public:
+    /**
+     * @brief Creates a new buffer.
+     *
+     * @param size The size of the fully decompressed data.
+     */
+    explicit PipelineBuffer(size_t size);
+
+    /**
+     * @brief Gets the buffer to decompress into.
+     *
+     * @return A pointer to the start of the buffer.
+     */
+    [[nodiscard]] uint8_t* data(void);
+
+    /**
+     * @brief Gets the size of the fully decompressed data.
+     *
+     * @return The size, in bytes.
+     */
+    [[nodiscard]] size_t size(void) const;
+
+    /**
+     * @brief Makes the start of the buffer available to the parsing thread.
+     * @note Only to be called by the decompressing thread.
+     * @note Throws a `LoadCancelled` if the parsing thread has stopped, in which case the rest of
+     *       the data isn't needed.
+     *
+     * @param filled The amount of bytes at the start of the buffer which are now filled.
+     */
+    void publish(size_t filled);
+
+    /**
+     * @brief Checks that the entire buffer has been published.
+     * @note Only to be called by the decompressing thread, once it's done.
+     * @note Throws a runtime error if it hasn't, since the parsing thread would wait forever.
+     */
+    void finish(void);
+
+    /**
+     * @brief Waits until at least the given amount of bytes are available.
+     * @note Only to be called by the parsing thread.
+     * @note Throws a runtime error if decompression stopped before filling them.
+     *
+     * @param required The amount of bytes which need to be available.
+     */
+    void wait_for(size_t required);
+
+    /**
+     * @brief Stops the pipeline, waking the other thread if it's waiting.
+     */
+    void abort(void);
+
+    /**
+     * @brief Gets how long the parsing thread has spent waiting on decompression.
+     *
+     * @return The total time spent waiting.
+     */
+    [[nodiscard]] std::chrono::steady_clock::duration time_waiting(void) const;
+
+   private:
+    static const constexpr size_t ABORTED = std::numeric_limits<size_t>::max();
+
+    std::unique_ptr<uint8_t[]> buffer;
+    size_t buffer_size;
+    std::atomic<size_t> filled = 0;
+
+    // Only touched by the decompressing thread
+    size_t last_published = 0;
+    // Only touched by the parsing thread
+    size_t known_filled = 0;
+    std::chrono::steady_clock::duration waiting{};
+};
+
+/**
+ * @brief Decompresses a set of hotfixes on a worker thread, while parsing it on this one.
+ * @note Throws a runtime error if either stage fails.
+ * @note Large sets load at close to the speed of the slower of the two stages, rather than the
+ *       sum of both.
+ *
+ * @param size The size of the decompressed set.
+ * @param decompress Function run on the worker thread, which decompresses the set into the buffer,
+ *                   publishing each chunk as it goes. Any exceptions `publish` throws
+ *                   should be left to propagate.
+ * @param hotfixes The set to load the hotfixes into.
+ * @param token The token to report progress and check for cancellation with.
+ * @param progress_start The progress fraction to report before anything has been parsed.
+ */
+void pipeline_hotfixes(size_t size,
+                       const std::function<void(PipelineBuffer&)>& decompress,
+                       HotfixSet& hotfixes,
+                       const LoadToken& token = {},
+                       float progress_start = 0.0F);
+
+/**
+ * @brief Parses a decompressed string pool.
+ * @note Throws a runtime error if the data is malformed.
+ *
+ * @param data The decompressed pool.
+ * @param size The size of the pool.
+ * @param pool The pool to load the strings into.
+ * @param token The token to report progress and check for cancellation with.
+ */
+void parse_string_pool(const uint8_t* data,
+                       size_t size,
+                       StringPool& pool,
+                       const LoadToken& token = {});
+
+/**
+ * @brief The operations a delta encoded set is made up of.
+ */
+enum class DeltaOp : uint32_t {
+    // Copy the next `count` hotfixes from the base set
+    COPY = 0,
+    // Skip over the next `count` hotfixes in the base set
+    SKIP = 1,
+    // Insert `count` new hotfixes, whose pool indexes directly follow the op
+    INSERT = 2,
+};
+
+/**
+ * @brief Parses the pool indexes out of a decompressed set which refers to a shared pool.
+ * @note Throws a runtime error if the data is malformed.
+ *
+ * @param data The decompressed set.
+ * @param size The size of the set.
+ * @return The pool indexes of each hotfix's key and value, one after the other.
+ */
+[[nodiscard]] std::vector<uint32_t> parse_pooled_ids(const uint8_t* data, size_t size);
+
+/**
+ * @brief Rebuilds the pool indexes of a set, by applying a decompressed delta to it's base set.
+ * @note Throws a runtime error if the data is malformed.
+ *
+ * @param data The decompressed delta.
+ * @param size The size of the delta.
+ * @param base The pool indexes of the base set.
+ * @return The pool indexes of the rebuilt set.
+ */
+[[nodiscard]] std::vector<uint32_t> apply_delta(const uint8_t* data,
+                                                size_t size,
+                                                const std::vector<uint32_t>& base);
+
+/**
+ * @brief Builds a set of hotfixes out of a list of pool indexes.
+ * @note Throws a runtime error if any indexes are outside of the pool.
+ *
+ * @param ids The pool indexes of each hotfix's key and value, one after the other.
+ * @param pool The pool holding the set's strings.
+ * @param hotfixes The set to load the hotfixes into.
+ * @param token The token to report progress and check for cancellation with.
+ */
+void build_pooled_hotfixes(const std::vector<uint32_t>& ids,
+                           const std::shared_ptr<const StringPool>& pool,
+                           HotfixSet& hotfixes,
+                           const LoadToken& token = {});
+
+/**
+ * @brief Parses the catalog which may follow the entries of an index or table of contents.
+ * @note Throws a runtime error if the data is malformed, in which case the info is left untouched.
+ * @note Leaves the info untouched if there's no catalog.
+ *
+ * @param data The start of the catalog, directly after the last entry.
+ * @param size The amount of bytes left after the last entry.
+ * @param info The info of each set, in the same order as the entries, to fill in.
+ */
+void parse_catalog(const uint8_t* data, size_t size, std::vector<SetInfo>& info);
+
+}  // namespace dhf::hfdat
+
+#endif /* HFDAT_DECODE_H */
@@ -0,0 +1,287 @@
+#include "pch.h"
+
+#include "hfdat/disk_cache.h"
+#include "hfdat/hotfix_set.h"
+#include "hfdat/mapped_file.h"
+
+namespace dhf::hfdat::disk_cache {
+
+namespace {
+
+const constexpr uint32_t CACHE_MAGIC = 0x43464844;  // "DHFC"
+const constexpr uint32_t CACHE_VERSION = 2;
+
+const constexpr auto CACHE_DIR_NAME = "dhf_cache";
+const constexpr auto CACHE_EXTENSION = ".dhfc";
+const constexpr uintmax_t CACHE_BUDGET = 512ULL * 1024 * 1024;
+
+// How much of the start and end of the hfdat to include in it's fingerprint
+const constexpr size_t FINGERPRINT_SAMPLE_SIZE = 0x10000;
+
+const constexpr uint64_t FNV_BASIS = 0xcbf29ce484222325;
+const constexpr uint64_t FNV_PRIME = 0x100000001b3;
+
+/**
+ * @brief The header at the start of each cache file.
+ * @note Directly followed by the offsets array, then by the strings' bytes, in the same layout as
+ *       a `StringPool`, so that they can be used straight out of the mapped file.
+ */
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fingerprint;
+    uint64_t name_hash;
+    uint32_t num_strings;
+    uint32_t num_bytes;
+};
+static_assert(sizeof(Header) % sizeof(uint32_t) == 0);
+// The size is part of the documented file layout
+static_assert(sizeof(Header) == 32);  // NOLINT(readability-magic-numbers)
+
+bool enabled = false;
+std::filesystem::path cache_dir;
+uint64_t fingerprint = 0;
+
+// Only one thread may write to the cache at once
+std::mutex store_mutex;
+
+/**
+ * @brief Advances an FNV-1a hash over a range of bytes.
+ *
+ * @param data The start of the data.
+ * @param len The length of data.
+ * @param hash The hash to advance.
+ * @return The new hash.
+ */
+uint64_t hash_advance(const void* data, size_t len, uint64_t hash = FNV_BASIS) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief Fingerprints an hfdat file's contents.
+ * @note Hashes the start and end of the file rather than all of it. For v2 files the end holds
+ *       the index, with the size of every set, and for gzip files it holds the crc of the entire
+ *       uncompressed archive, so this still changes whenever the contents do.
+ *
+ * @param path The path to the hfdat file.
+ * @return The fingerprint.
+ */
+uint64_t get_fingerprint(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary | std::ios::ate};
+    auto file_size = (uint64_t)file.tellg();
+    auto sample_size = (size_t)std::min<uint64_t>(file_size, FINGERPRINT_SAMPLE_SIZE);
+
+    std::vector<uint8_t> sample(sample_size);
+    auto hash = hash_advance(&file_size, sizeof(file_size));
+
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(sample.data()), (std::streamsize)sample.size());
+    hash = hash_advance(sample.data(), sample.size(), hash);
+
+    file.seekg((std::streamoff)(file_size - sample_size));
+    file.read(reinterpret_cast<char*>(sample.data()), (std::streamsize)sample.size());
+    hash = hash_advance(sample.data(), sample.size(), hash);
+
+    if (!file) {
+        throw std::runtime_error("Failed to read hfdat file");
+    }
+    return hash;
+}
+
+/**
+ * @brief Gets the path of the cache file for a set.
+ *
+ * @param name_hash The hash of the set's name.
+ * @return The path to the cache file.
+ */
+std::filesystem::path get_entry_path(uint64_t name_hash) {
+    std::stringstream stream;
+    stream << std::hex << std::setfill('0') << std::setw(sizeof(fingerprint) * 2) << fingerprint
+           << '_' << std::setw(sizeof(name_hash) * 2) << name_hash << CACHE_EXTENSION;
+    return cache_dir / stream.str();
+}
+
+/**
+ * @brief Evicts the least recently used cache files until the cache fits within it's budget.
+ */
+void evict_to_budget(void) {
+    struct Entry {
+        std::filesystem::file_time_type last_used;
+        uintmax_t size;
+        std::filesystem::path path;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total_size = 0;
+
+    std::error_code err;
+    for (const auto& dir_entry : std::filesystem::directory_iterator{cache_dir, err}) {
+        if (!dir_entry.is_regular_file(err) || dir_entry.path().extension() != CACHE_EXTENSION) {
+            continue;
+        }
+        auto& entry = entries.emplace_back(dir_entry.last_write_time(err), dir_entry.file_size(err),
+                                           dir_entry.path());
+        total_size += entry.size;
+    }
+
+    std::ranges::sort(entries, {}, &Entry::last_used);
+    for (const auto& entry : entries) {
+        if (total_size <= CACHE_BUDGET) {
+            break;
+        }
+        if (std::filesystem::remove(entry.path, err)) {
+            total_size -= entry.size;
+        }
+    }
+}
+
+}  // namespace
+
+void init(const std::filesystem::path& hfdat_path) {
+    enabled = false;
+    try {
+        fingerprint = get_fingerprint(hfdat_path);
+        cache_dir = hfdat_path.parent_path() / CACHE_DIR_NAME;
+        enabled = true;
+    } catch (const std::exception& ex) {
+        std::cerr << "[dhf] Failed to fingerprint hfdat file, disabling disk cache: " << ex.what()
+                  << "\n";
+    }
+}
+
+bool load(const std::string& name, HotfixSet& hotfixes) {
+    if (!enabled) {
+        return false;
+    }
+
+    auto name_hash = hash_advance(name.data(), name.size());
+    auto path = get_entry_path(name_hash);
+
+    std::error_code err;
+    if (!std::filesystem::exists(path, err)) {
+        return false;
+    }
+
+    try {
+        auto mapped = std::make_shared<MappedFile>(path);
+
+        Header header{};
+        if (mapped->size < sizeof(header)) {
+            throw std::runtime_error("File is truncated");
+        }
+        memcpy(&header, mapped->data, sizeof(header));
+        if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION
+            || header.fingerprint != fingerprint || header.name_hash != name_hash) {
+            throw std::runtime_error("File has an invalid header");
+        }
+
+        auto offsets_size = ((uint64_t)header.num_strings + 1) * sizeof(uint32_t);
+        if (mapped->size != sizeof(header) + offsets_size + header.num_bytes) {
+            throw std::runtime_error("File has the wrong size");
+        }
+
+        // The header keeps these aligned, and the view is page aligned
+        const auto* offsets = reinterpret_cast<const uint32_t*>(&mapped->data[sizeof(header)]);
+        const auto* bytes = &mapped->data[sizeof(header) + offsets_size];
+
+        // Validate the offsets now, so we can trust them later
+        if (offsets[0] != 0
+            || (offsets[header.num_strings] & ~StringPool::WIDE_FLAG) != header.num_bytes) {
+            throw std::runtime_error("File has invalid offsets");
+        }
+        for (uint32_t i = 0; i < header.num_strings; i++) {
+            auto start = offsets[i] & ~StringPool::WIDE_FLAG;
+            auto end = offsets[i + 1] & ~StringPool::WIDE_FLAG;
+            auto wide = (offsets[i + 1] & StringPool::WIDE_FLAG) != 0;
+            if (end < start || (wide && (end - start) % sizeof(wchar_t) != 0)) {
+                throw std::runtime_error("File has invalid offsets");
+            }
+        }
+
+        hotfixes = HotfixSet{StringPool{mapped, offsets, bytes, header.num_strings}};
+
+        // Mark as recently used, for eviction
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), err);
+        return true;
+    } catch (const std::exception& ex) {
+        std::cerr << "[dhf] Ignoring invalid disk cache file '" << path.filename().string()
+                  << "': " << ex.what() << "\n";
+        std::filesystem::remove(path, err);
+        return false;
+    }
+}
+
+void store(const std::string& name, const HotfixSet& hotfixes) {
+    if (!enabled) {
+        return;
+    }
+
+    const std::lock_guard<std::mutex> lock{store_mutex};
+
+    auto name_hash = hash_advance(name.data(), name.size());
+    auto path = get_entry_path(name_hash);
+    auto temp_path = std::filesystem::path{path}.concat(".tmp");
+
+    try {
+        std::filesystem::create_directories(cache_dir);
+
+        std::vector<uint32_t> offsets;
+        offsets.reserve((hotfixes.size() * 2) + 1);
+        offsets.push_back(0);
+        uint64_t num_bytes = 0;
+        auto add_offset = [&](const PooledString& str) {
+            num_bytes += str.byte_size();
+            offsets.push_back((uint32_t)num_bytes | (str.is_wide() ? StringPool::WIDE_FLAG : 0));
+        };
+        for (size_t i = 0; i < hotfixes.size(); i++) {
+            auto [key, value] = hotfixes[i];
+            add_offset(key);
+            add_offset(value);
+        }
+        if (num_bytes >= StringPool::WIDE_FLAG) {
+            throw std::runtime_error("Set is too large");
+        }
+
+        Header header{CACHE_MAGIC,
+                      CACHE_VERSION,
+                      fingerprint,
+                      name_hash,
+                      (uint32_t)(offsets.size() - 1),
+                      (uint32_t)num_bytes};
+
+        {
+            std::ofstream file{temp_path, std::ios::binary | std::ios::trunc};
+            auto write = [&](const void* data, size_t len) {
+                file.write(reinterpret_cast<const char*>(data), (std::streamsize)len);
+            };
+
+            write(&header, sizeof(header));
+            write(offsets.data(), offsets.size() * sizeof(uint32_t));
+            for (size_t i = 0; i < hotfixes.size(); i++) {
+                auto [key, value] = hotfixes[i];
+                write(key.data(), key.byte_size());
+                write(value.data(), value.byte_size());
+            }
+
+            if (!file) {
+                throw std::runtime_error("Failed to write file");
+            }
+        }
+
+        // Rename into place, so a crash part way through never leaves a partial file behind
+        std::filesystem::rename(temp_path, path);
+    } catch (const std::exception& ex) {
+        std::cerr << "[dhf] Failed to store set in disk cache: " << ex.what() << "\n";
+        std::error_code err;
+        std::filesystem::remove(temp_path, err);
+        return;
+    }
+
+    evict_to_budget();
+}
+
+}  // namespace dhf::hfdat::disk_cache
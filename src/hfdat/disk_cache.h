@@ -0,0 +1,41 @@
+#ifndef HFDAT_DISK_CACHE_H
+#define HFDAT_DISK_CACHE_H
+
+#include "pch.h"
+
+#include "hfdat/hotfix_set.h"
+
+namespace dhf::hfdat::disk_cache {
+
+/**
+ * @brief Initalizes the disk cache for the given hfdat file.
+ * @note Disables the cache if the file couldn't be fingerprinted.
+ * @note Sets are cached in a `dhf_cache` folder next to the hfdat, one `.dhfc` file each. Each file
+ *       starts with a 32 byte header, directly followed by the string offsets.
+ *
+ * @param hfdat_path The path to the hfdat file sets are being loaded from.
+ */
+void init(const std::filesystem::path& hfdat_path);
+
+/**
+ * @brief Tries to load a set out of the disk cache, by mapping it into memory.
+ *
+ * @param name The full name of the set.
+ * @param hotfixes The set to load the hotfixes into. Only modified on success.
+ * @return True if the set was in the cache.
+ */
+[[nodiscard]] bool load(const std::string& name, HotfixSet& hotfixes);
+
+/**
+ * @brief Stores a freshly decoded set in the disk cache, evicting old sets if it's grown too large.
+ * @note Failures are logged, but otherwise ignored.
+ * @note The least recently used files are evicted once the folder holds over 512 MiB.
+ *
+ * @param name The full name of the set.
+ * @param hotfixes The set to store.
+ */
+void store(const std::string& name, const HotfixSet& hotfixes);
+
+}  // namespace dhf::hfdat::disk_cache
+
+#endif /* HFDAT_DISK_CACHE_H */
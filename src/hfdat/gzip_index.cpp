@@ -0,0 +1,656 @@
+#include "pch.h"
+
+#include "hfdat/decode.h"
+#include "hfdat/gzip_index.h"
+#include "hfdat/load_token.h"
+
+namespace dhf::hfdat::gzip_index {
+
+namespace {
+
+const constexpr uint32_t INDEX_MAGIC = 0x49464844;  // "DHFI"
+const constexpr uint32_t INDEX_VERSION = 1;
+const constexpr auto INDEX_EXTENSION = ".idx";
+
+// How much uncompressed data to leave between seek points
+const constexpr uint64_t SPAN = 4ULL * 1024 * 1024;
+// Deflate's maximum back reference distance, the amount of history each seek point needs to save
+const constexpr size_t WINDOW_SIZE = 32768;
+const constexpr size_t CHUNK_SIZE = 0x10000;
+
+// 32 (auto detect header) + 15 (max window bits)
+const constexpr int GZIP_WINDOW_BITS = 47;
+const constexpr int RAW_WINDOW_BITS = -15;
+
+const constexpr size_t TAR_BLOCK_SIZE = 512;
+const constexpr auto TOC_NAME = ".toc";
+
+/**
+ * @brief Struct holding all the state needed to restart decompression in the middle of the file.
+ */
+struct Checkpoint {
+    // Offset of the first full byte of the next deflate block in the compressed file
+    uint64_t in;
+    // Offset in the uncompressed tar
+    uint64_t out;
+    // Amount of bits of the previous byte which belong to the next block
+    uint8_t bits;
+    // The previous window of uncompressed data, zlib compressed
+    std::vector<uint8_t> window;
+};
+
+std::filesystem::path index_path;
+bool loaded = false;
+
+std::vector<Member> members;
+std::vector<Checkpoint> checkpoints;
+
+/**
+ * @brief Incrementally parses tar headers out of a stream of uncompressed data.
+ */
+class TarScanner {
+   public:
+    std::vector<Member> members;
+
+    /**
+     * @brief Feeds the next block of uncompressed data into the scanner.
+     *
+     * @param data The data.
+     * @param len The length of the data.
+     */
+    void feed(const uint8_t* data, size_t len) {
+        while (len > 0 && !this->finished) {
+            size_t consumed = 0;
+            if (this->data_remaining == 0) {
+                consumed = std::min(len, TAR_BLOCK_SIZE - this->header_filled);
+                memcpy(&this->header[this->header_filled], data, consumed);
+                this->header_filled += consumed;
+
+                this->offset += consumed;
+                if (this->header_filled == TAR_BLOCK_SIZE) {
+                    this->header_filled = 0;
+                    this->parse_header();
+                }
+            } else {
+                consumed = (size_t)std::min<uint64_t>(len, this->data_remaining);
+                if (this->collecting && this->extra_data.size() < this->entry_size) {
+                    auto wanted = (size_t)std::min<uint64_t>(
+                        consumed, this->entry_size - this->extra_data.size());
+                    this->extra_data.append(reinterpret_cast<const char*>(data), wanted);
+                }
+                this->data_remaining -= consumed;
+                this->offset += consumed;
+                if (this->data_remaining == 0) {
+                    this->finish_entry();
+                }
+            }
+
+            data += consumed;
+            len -= consumed;
+        }
+    }
+
+   private:
+    uint64_t offset = 0;
+    bool finished = false;
+
+    std::array<uint8_t, TAR_BLOCK_SIZE> header{};
+    size_t header_filled = 0;
+
+    uint64_t entry_size = 0;
+    uint64_t data_remaining = 0;
+    char entry_type = '\0';
+
+    bool collecting = false;
+    std::string extra_data;
+    std::string next_name;
+
+    /**
+     * @brief Reads a numeric field out of the current header.
+     *
+     * @param start The offset of the field.
+     * @param len The length of the field.
+     * @return The field's value.
+     */
+    [[nodiscard]] uint64_t read_number(size_t start, size_t len) const {
+        uint64_t value = 0;
+
+        // GNU base-256 extension
+        // NOLINTNEXTLINE(readability-magic-numbers)
+        if ((this->header[start] & 0x80) != 0) {
+            for (size_t i = start + 1; i < start + len; i++) {
+                // NOLINTNEXTLINE(readability-magic-numbers)
+                value = (value << 8) | this->header[i];
+            }
+            return value;
+        }
+
+        for (size_t i = start; i < start + len; i++) {
+            auto chr = this->header[i];
+            if (chr == ' ') {
+                continue;
+            }
+            if (chr < '0' || chr > '7') {
+                break;
+            }
+            value = (value * 8) + (chr - '0');
+        }
+        return value;
+    }
+
+    /**
+     * @brief Reads a null-terminated string field out of the current header.
+     *
+     * @param start The offset of the field.
+     * @param len The max length of the field.
+     * @return The field's value.
+     */
+    [[nodiscard]] std::string read_string(size_t start, size_t len) const {
+        const auto* begin = reinterpret_cast<const char*>(&this->header[start]);
+        return {begin, strnlen(begin, len)};
+    }
+
+    /**
+     * @brief Parses the header block which was just read.
+     */
+    void parse_header(void) {
+        // NOLINTBEGIN(readability-magic-numbers)
+        if (std::ranges::all_of(this->header, [](auto chr) { return chr == 0; })) {
+            this->finished = true;
+            return;
+        }
+
+        auto name = this->read_string(0, 100);
+        if (memcmp(&this->header[257], "ustar", 5) == 0) {
+            auto prefix = this->read_string(345, 155);
+            if (!prefix.empty()) {
+                name = prefix + "/" + name;
+            }
+        }
+
+        this->entry_size = this->read_number(124, 12);
+        this->entry_type = (char)this->header[156];
+        // NOLINTEND(readability-magic-numbers)
+
+        this->data_remaining =
+            (this->entry_size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+
+        switch (this->entry_type) {
+            case '\0':
+            case '0':
+            case '7':
+                if (!this->next_name.empty()) {
+                    name = std::move(this->next_name);
+                    this->next_name.clear();
+                }
+                if (name != TOC_NAME) {
+                    this->members.push_back({std::move(name), this->offset, this->entry_size});
+                }
+                break;
+
+            // PAX extended header, and GNU long name, both of which may override the next name
+            case 'x':
+            case 'L':
+                this->collecting = true;
+                this->extra_data.clear();
+                break;
+
+            default:
+                break;
+        }
+
+        if (this->data_remaining == 0) {
+            this->finish_entry();
+        }
+    }
+
+    /**
+     * @brief Finishes processing the current entry, once all it's data has been read.
+     */
+    void finish_entry(void) {
+        if (!this->collecting) {
+            return;
+        }
+        this->collecting = false;
+
+        if (this->entry_type == 'L') {
+            this->next_name = this->extra_data.substr(0, strnlen(this->extra_data.c_str(),
+                                                                 this->extra_data.size()));
+            return;
+        }
+
+        // PAX records are of the form "<len> <key>=<value>\n", where len includes itself
+        size_t pos = 0;
+        while (pos < this->extra_data.size()) {
+            auto space = this->extra_data.find(' ', pos);
+            if (space == std::string::npos) {
+                break;
+            }
+            auto record_len = std::strtoull(&this->extra_data[pos], nullptr, 10);
+            if (record_len == 0 || pos + record_len > this->extra_data.size()) {
+                break;
+            }
+
+            std::string_view record{&this->extra_data[space + 1], pos + record_len - space - 2};
+            auto equals = record.find('=');
+            if (equals != std::string_view::npos && record.substr(0, equals) == "path") {
+                this->next_name = record.substr(equals + 1);
+            }
+
+            pos += record_len;
+        }
+    }
+};
+
+/**
+ * @brief Gets the path of the index cache file for the given archive.
+ *
+ * @param path The path to the archive.
+ * @return The path to it's index.
+ */
+std::filesystem::path get_cache_path(const std::filesystem::path& path) {
+    return std::filesystem::path{path}.concat(INDEX_EXTENSION);
+}
+
+/**
+ * @brief Gets the size and modification time of a file, used to check if a cached index is stale.
+ *
+ * @param path The path to the file.
+ * @return A pair of the file size and modification time.
+ */
+std::pair<uint64_t, int64_t> get_file_stamp(const std::filesystem::path& path) {
+    return {std::filesystem::file_size(path),
+            std::filesystem::last_write_time(path).time_since_epoch().count()};
+}
+
+/**
+ * @brief Adds a new checkpoint.
+ *
+ * @param bits The amount of bits of the previous byte which belong to the next block.
+ * @param in The offset into the compressed file.
+ * @param out The offset into the uncompressed tar.
+ * @param left The amount of free space left in the window buffer.
+ * @param window The circular window buffer.
+ */
+void add_checkpoint(uint8_t bits,
+                    uint64_t in,
+                    uint64_t out,
+                    size_t left,
+                    const std::array<uint8_t, WINDOW_SIZE>& window) {
+    // Unroll the circular buffer
+    std::array<uint8_t, WINDOW_SIZE> unrolled{};
+    if (left != 0) {
+        memcpy(unrolled.data(), &window[WINDOW_SIZE - left], left);
+    }
+    if (left < WINDOW_SIZE) {
+        memcpy(&unrolled[left], window.data(), WINDOW_SIZE - left);
+    }
+
+    // The window's normally very compressible, and we're going to be writing it all to disk
+    std::vector<uint8_t> compressed(compressBound(WINDOW_SIZE));
+    auto compressed_size = (uLongf)compressed.size();
+    auto ret =
+        compress2(compressed.data(), &compressed_size, unrolled.data(), WINDOW_SIZE, Z_BEST_SPEED);
+    if (ret != Z_OK) {
+        throw std::runtime_error("Failed to compress checkpoint window: " + std::to_string(ret));
+    }
+    compressed.resize(compressed_size);
+
+    checkpoints.push_back({in, out, bits, std::move(compressed)});
+}
+
+/**
+ * @brief Builds a new index by decompressing the entire archive.
+ *
+ * @param path The path to the archive.
+ * @param token The token to report progress and check for cancellation with.
+ */
+void build_index(const std::filesystem::path& path, const LoadToken& token) {
+    members.clear();
+    checkpoints.clear();
+
+    auto file_size = std::filesystem::file_size(path);
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error("Failed to open archive");
+    }
+
+    InflateStream stream{GZIP_WINDOW_BITS};
+    auto& strm = stream.strm;
+
+    std::vector<uint8_t> input(CHUNK_SIZE);
+    std::array<uint8_t, WINDOW_SIZE> window{};
+
+    TarScanner scanner{};
+
+    uint64_t total_in = 0;
+    uint64_t total_out = 0;
+    uint64_t last_checkpoint = 0;
+
+    int ret{};
+    do {
+        file.read(reinterpret_cast<char*>(input.data()), (std::streamsize)input.size());
+        auto got = file.gcount();
+        if (got <= 0) {
+            throw std::runtime_error("Archive is truncated");
+        }
+        strm.avail_in = (uInt)got;
+        strm.next_in = input.data();
+
+        token.update(total_in, file_size);
+
+        do {
+            if (strm.avail_out == 0) {
+                strm.avail_out = WINDOW_SIZE;
+                strm.next_out = window.data();
+            }
+            auto* out_start = strm.next_out;
+
+            total_in += strm.avail_in;
+            total_out += strm.avail_out;
+            ret = stream.inflate(Z_BLOCK);
+            total_in -= strm.avail_in;
+            total_out -= strm.avail_out;
+
+            scanner.feed(out_start, strm.next_out - out_start);
+
+            if (ret == Z_STREAM_END) {
+                break;
+            }
+
+            // If we're at the end of a deflate block, which isn't the last one, consider adding a
+            // checkpoint
+            // NOLINTNEXTLINE(readability-magic-numbers)
+            auto data_type = strm.data_type;
+            // NOLINTNEXTLINE(readability-magic-numbers)
+            if ((data_type & 128) != 0 && (data_type & 64) == 0
+                && (total_out == 0 || total_out - last_checkpoint > SPAN)) {
+                // NOLINTNEXTLINE(readability-magic-numbers)
+                add_checkpoint((uint8_t)(data_type & 7), total_in, total_out, strm.avail_out,
+                               window);
+                last_checkpoint = total_out;
+            }
+        } while (strm.avail_in != 0);
+    } while (ret != Z_STREAM_END);
+
+    members = std::move(scanner.members);
+}
+
+/**
+ * @brief Tries to load a cached index from disk.
+ *
+ * @param path The path to the archive.
+ * @return True if a valid index was loaded.
+ */
+bool load_cached_index(const std::filesystem::path& path) {
+    members.clear();
+    checkpoints.clear();
+
+    auto cache_path = get_cache_path(path);
+    std::ifstream file{cache_path, std::ios::binary};
+    if (!file) {
+        return false;
+    }
+    // Nothing stored in the index can be longer than the index itself, checking against this stops
+    //  a corrupt length from triggering a huge allocation
+    auto cache_size = std::filesystem::file_size(cache_path);
+
+    auto read = [&]<typename T>(T* value, size_t len = sizeof(T)) {
+        file.read(reinterpret_cast<char*>(value), (std::streamsize)len);
+        if (!file) {
+            throw std::runtime_error("Cached index is truncated");
+        }
+    };
+
+    uint32_t magic{};
+    uint32_t version{};
+    uint64_t file_size{};
+    int64_t mtime{};
+    read(&magic);
+    read(&version);
+    read(&file_size);
+    read(&mtime);
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION
+        || std::make_pair(file_size, mtime) != get_file_stamp(path)) {
+        return false;
+    }
+
+    uint32_t num_members{};
+    uint32_t num_checkpoints{};
+    read(&num_members);
+    read(&num_checkpoints);
+
+    members.reserve(num_members);
+    for (uint32_t i = 0; i < num_members; i++) {
+        uint32_t name_len{};
+        read(&name_len);
+        if (name_len > cache_size) {
+            throw std::runtime_error("Cached index has an invalid member name length");
+        }
+        auto& member = members.emplace_back(std::string(name_len, '\0'), 0, 0);
+        read(member.name.data(), name_len);
+        read(&member.data_offset);
+        read(&member.size);
+        if (member.size > std::numeric_limits<uint64_t>::max() - member.data_offset) {
+            throw std::runtime_error("Cached index has an invalid member size");
+        }
+    }
+
+    checkpoints.reserve(num_checkpoints);
+    for (uint32_t i = 0; i < num_checkpoints; i++) {
+        auto& checkpoint = checkpoints.emplace_back();
+        read(&checkpoint.in);
+        read(&checkpoint.out);
+        read(&checkpoint.bits);
+
+        // The bits come from the low three bits of zlib's data type, and a partial byte means the
+        //  previous one must also be in the file
+        // NOLINTNEXTLINE(readability-magic-numbers)
+        if (checkpoint.bits > 7 || checkpoint.in > file_size
+            || (checkpoint.bits != 0 && checkpoint.in == 0)) {
+            throw std::runtime_error("Cached index has an invalid checkpoint");
+        }
+        // Extracting binary searches on the uncompressed offsets
+        if (i > 0 && checkpoint.out <= checkpoints[i - 1].out) {
+            throw std::runtime_error("Cached index checkpoints are out of order");
+        }
+
+        uint32_t window_size{};
+        read(&window_size);
+        if (window_size > compressBound(WINDOW_SIZE)) {
+            throw std::runtime_error("Cached index has an invalid checkpoint window");
+        }
+        checkpoint.window.resize(window_size);
+        read(checkpoint.window.data(), window_size);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Saves the current index to disk.
+ *
+ * @param path The path to the archive.
+ */
+void save_cached_index(const std::filesystem::path& path) {
+    auto cache_path = get_cache_path(path);
+    auto temp_path = std::filesystem::path{cache_path}.concat(".tmp");
+
+    try {
+        {
+            std::ofstream file{temp_path, std::ios::binary | std::ios::trunc};
+
+            auto write = [&]<typename T>(const T* value, size_t len = sizeof(T)) {
+                file.write(reinterpret_cast<const char*>(value), (std::streamsize)len);
+            };
+
+            auto [file_size, mtime] = get_file_stamp(path);
+            auto num_members = (uint32_t)members.size();
+            auto num_checkpoints = (uint32_t)checkpoints.size();
+
+            write(&INDEX_MAGIC);
+            write(&INDEX_VERSION);
+            write(&file_size);
+            write(&mtime);
+            write(&num_members);
+            write(&num_checkpoints);
+
+            for (const auto& member : members) {
+                auto name_len = (uint32_t)member.name.size();
+                write(&name_len);
+                write(member.name.data(), name_len);
+                write(&member.data_offset);
+                write(&member.size);
+            }
+
+            for (const auto& checkpoint : checkpoints) {
+                auto window_size = (uint32_t)checkpoint.window.size();
+                write(&checkpoint.in);
+                write(&checkpoint.out);
+                write(&checkpoint.bits);
+                write(&window_size);
+                write(checkpoint.window.data(), window_size);
+            }
+
+            if (!file) {
+                throw std::runtime_error("Failed to write index");
+            }
+        }
+
+        // Rename into place, so a crash part way through never leaves a partial index behind
+        std::filesystem::rename(temp_path, cache_path);
+    } catch (const std::exception&) {
+        std::error_code err;
+        std::filesystem::remove(temp_path, err);
+        throw;
+    }
+}
+
+}  // namespace
+
+bool is_gzip(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    std::array<uint8_t, 2> magic{};
+    file.read(reinterpret_cast<char*>(magic.data()), magic.size());
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    return file && magic[0] == 0x1F && magic[1] == 0x8B;
+}
+
+const std::vector<Member>& init(const std::filesystem::path& path, const LoadToken& token) {
+    if (loaded && index_path == path) {
+        return members;
+    }
+    loaded = false;
+    index_path = path;
+
+    try {
+        if (load_cached_index(path)) {
+            loaded = true;
+            return members;
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "[dhf] Failed to load cached archive index, rebuilding: " << ex.what()
+                  << "\n";
+    }
+
+    std::cout << "[dhf] Building archive index, this may take a while\n";
+    build_index(path, token);
+    loaded = true;
+
+    try {
+        save_cached_index(path);
+    } catch (const std::exception& ex) {
+        std::cerr << "[dhf] Failed to save archive index: " << ex.what() << "\n";
+    }
+
+    return members;
+}
+
+std::vector<uint8_t> extract(uint64_t offset, uint64_t size, const LoadToken& token) {
+    if (!loaded) {
+        throw std::runtime_error("No archive index loaded");
+    }
+
+    // Find the last checkpoint before the offset
+    auto checkpoint_it = std::ranges::upper_bound(checkpoints, offset, {}, &Checkpoint::out);
+    if (checkpoint_it == checkpoints.begin()) {
+        throw std::runtime_error("Couldn't find checkpoint in archive index");
+    }
+    const auto& checkpoint = *(checkpoint_it - 1);
+
+    std::ifstream file{index_path, std::ios::binary};
+    file.seekg((std::streamoff)(checkpoint.in - (checkpoint.bits != 0 ? 1 : 0)));
+    if (!file) {
+        throw std::runtime_error("Failed to seek archive");
+    }
+
+    InflateStream stream{RAW_WINDOW_BITS};
+    auto& strm = stream.strm;
+
+    if (checkpoint.bits != 0) {
+        auto byte = file.get();
+        if (byte == std::char_traits<char>::eof()) {
+            throw std::runtime_error("Archive is truncated");
+        }
+        // NOLINTNEXTLINE(readability-magic-numbers)
+        inflatePrime(&strm, checkpoint.bits, byte >> (8 - checkpoint.bits));
+    }
+
+    std::array<uint8_t, WINDOW_SIZE> window{};
+    auto window_size = (uLongf)window.size();
+    auto ret = uncompress(window.data(), &window_size, checkpoint.window.data(),
+                          (uLong)checkpoint.window.size());
+    if (ret != Z_OK || window_size != WINDOW_SIZE) {
+        throw std::runtime_error("Failed to decompress checkpoint window: " + std::to_string(ret));
+    }
+    inflateSetDictionary(&strm, window.data(), WINDOW_SIZE);
+
+    std::vector<uint8_t> input(CHUNK_SIZE);
+    std::vector<uint8_t> output(size);
+
+    // Reuse the window as a scratch buffer for the data we need to skip over
+    uint64_t skip = offset - checkpoint.out;
+    uint64_t filled = 0;
+
+    while (filled < size) {
+        if (strm.avail_in == 0) {
+            file.read(reinterpret_cast<char*>(input.data()), (std::streamsize)input.size());
+            auto got = file.gcount();
+            if (got <= 0) {
+                throw std::runtime_error("Archive is truncated");
+            }
+            strm.avail_in = (uInt)got;
+            strm.next_in = input.data();
+        }
+
+        if (skip > 0) {
+            strm.next_out = window.data();
+            strm.avail_out = (uInt)std::min<uint64_t>(skip, WINDOW_SIZE);
+        } else {
+            strm.next_out = &output[filled];
+            strm.avail_out = (uInt)std::min<uint64_t>(size - filled,
+                                                      std::numeric_limits<uInt>::max());
+        }
+        auto available = strm.avail_out;
+
+        ret = stream.inflate(Z_NO_FLUSH);
+
+        auto produced = available - strm.avail_out;
+        if (skip > 0) {
+            skip -= produced;
+        } else {
+            filled += produced;
+        }
+
+        auto total = (offset - checkpoint.out) + size;
+        token.update(total - skip - (size - filled), total, 0.0F, PARSE_PROGRESS_START);
+
+        if (ret == Z_STREAM_END && filled < size) {
+            throw std::runtime_error("Archive ended early");
+        }
+    }
+
+    return output;
+}
+
+}  // namespace dhf::hfdat::gzip_index
@@ -0,0 +1,52 @@
+#ifndef HFDAT_GZIP_INDEX_H
+#define HFDAT_GZIP_INDEX_H
+
+#include "pch.h"
+
+#include "hfdat/load_token.h"
+
+namespace dhf::hfdat::gzip_index {
+
+/**
+ * @brief Struct holding info about a file inside the tar.
+ */
+struct Member {
+    std::string name;
+    uint64_t data_offset;
+    uint64_t size;
+};
+
+/**
+ * @brief Checks if the given file is gzip compressed.
+ *
+ * @param path The path to the file.
+ * @return True if the file is gzip compressed.
+ */
+[[nodiscard]] bool is_gzip(const std::filesystem::path& path);
+
+/**
+ * @brief Loads the seek point index for a `.tar.gz`, building and caching a new one if needed.
+ * @note Building an index requires decompressing the entire file.
+ *
+ * @param path The path to the `.tar.gz`.
+ * @param token The token to report progress and check for cancellation with.
+ * @return A list of all the files in the tar.
+ */
+const std::vector<Member>& init(const std::filesystem::path& path, const LoadToken& token = {});
+
+/**
+ * @brief Extracts a range of data out of the uncompressed tar, using the loaded index.
+ * @note Throws a runtime error on failure.
+ *
+ * @param offset The offset in the uncompressed tar to start extracting from.
+ * @param size The amount of bytes to extract.
+ * @param token The token to report progress and check for cancellation with.
+ * @return The extracted data.
+ */
+[[nodiscard]] std::vector<uint8_t> extract(uint64_t offset,
+                                           uint64_t size,
+                                           const LoadToken& token = {});
+
+}  // namespace dhf::hfdat::gzip_index
+
+#endif /* HFDAT_GZIP_INDEX_H */
@@ -0,0 +1,312 @@
+#include "pch.h"
+
+#include "hfdat/disk_cache.h"
+#include "hfdat/hfdat.h"
+#include "hfdat/load_token.h"
+#include "hfdat/tar.h"
+#include "hfdat/v2.h"
+#include "settings.h"
+
+namespace dhf::hfdat {
+
+namespace {
+
+const constexpr auto NO_LOADED_FILE = "n/a";
+
+/**
+ * @brief The different hfdat file formats we can read.
+ */
+enum class Format {
+    NONE,
+    TAR,
+    V2,
+};
+
+Format hfdat_format = Format::NONE;
+// Sets in pooled files only hold indexes into the shared pool, caching each one on disk would store
+//  it's own copy of every string, and lose the sharing between sets once mapped back in
+bool use_disk_cache = false;
+
+std::vector<std::string> hotfix_names_internal;
+std::vector<SetInfo> hotfix_info_internal;
+std::string hfdat_name_internal = NO_LOADED_FILE;
+
+// Snapshots are only ever replaced as a whole, so readers always see a consistent set
+std::atomic<std::shared_ptr<const LoadedHotfixes>> loaded_hotfixes{
+    std::make_shared<const LoadedHotfixes>(NO_LOADED_FILE, false, HotfixSet{})};
+
+// Only one load may read from the file at once
+std::mutex file_mutex;
+
+std::mutex pending_load_mutex;
+std::shared_ptr<AsyncLoad> pending_load;
+
+const constexpr size_t DEFAULT_CACHE_BUDGET = 64ULL * 1024 * 1024;
+
+// Recently decoded sets, most recently used first
+std::mutex cache_mutex;
+std::list<std::shared_ptr<const LoadedHotfixes>> cache;
+CacheStats cache_stats{0, 0, 0, 0, DEFAULT_CACHE_BUDGET};
+
+/**
+ * @brief Evicts the least recently used sets until the cache fits within it's budget.
+ * @note Assumes the cache mutex is held.
+ */
+void evict_to_budget(void) {
+    while (!cache.empty() && cache_stats.resident_bytes > cache_stats.budget_bytes) {
+        cache_stats.resident_bytes -= cache.back()->hotfixes.memory_usage();
+        cache.pop_back();
+    }
+    cache_stats.num_sets = cache.size();
+}
+
+/**
+ * @brief Looks up a set in the cache, marking it as recently used.
+ * @note Counts towards the cache hit/miss stats.
+ *
+ * @param name The full name of the hotfixes to look up.
+ * @return The cached hotfixes, or null if they're not cached.
+ */
+std::shared_ptr<const LoadedHotfixes> find_cached(const std::string& name) {
+    const std::lock_guard<std::mutex> lock{cache_mutex};
+
+    auto cached = std::ranges::find(cache, name, &LoadedHotfixes::name);
+    if (cached == cache.end()) {
+        cache_stats.misses++;
+        return nullptr;
+    }
+
+    cache_stats.hits++;
+    cache.splice(cache.begin(), cache, cached);
+    return cache.front();
+}
+
+/**
+ * @brief Adds a freshly decoded set to the cache.
+ *
+ * @param hotfixes The hotfixes to add.
+ */
+void add_to_cache(std::shared_ptr<const LoadedHotfixes> hotfixes) {
+    const std::lock_guard<std::mutex> lock{cache_mutex};
+
+    auto size = hotfixes->hotfixes.memory_usage();
+    if (size > cache_stats.budget_bytes) {
+        return;
+    }
+
+    // Another load may have finished decoding the same set while we were working on ours
+    std::erase_if(cache, [&](const auto& cached) {
+        if (cached->name != hotfixes->name) {
+            return false;
+        }
+        cache_stats.resident_bytes -= cached->hotfixes.memory_usage();
+        return true;
+    });
+
+    cache.push_front(std::move(hotfixes));
+    cache_stats.resident_bytes += size;
+    evict_to_budget();
+}
+
+/**
+ * @brief Decodes a set of hotfixes out of the hfdat file.
+ *
+ * @param name The full name of the hotfixes to load.
+ * @param token The token to report progress and check for cancellation with.
+ * @return The loaded hotfixes.
+ */
+std::shared_ptr<const LoadedHotfixes> load_from_file(const std::string& name,
+                                                     const LoadToken& token) {
+    auto start = std::chrono::steady_clock::now();
+
+    auto name_it = std::ranges::find(hotfix_names_internal, name);
+    if (name_it == hotfix_names_internal.end()) {
+        throw std::runtime_error("Couldn't find hotfixes with that name");
+    }
+    auto idx = (size_t)(name_it - hotfix_names_internal.begin());
+
+    auto result = std::make_shared<LoadedHotfixes>(name, false, HotfixSet{});
+
+    auto from_disk_cache = use_disk_cache && disk_cache::load(name, result->hotfixes);
+    if (!from_disk_cache) {
+        {
+            const std::lock_guard<std::mutex> lock{file_mutex};
+            switch (hfdat_format) {
+                case Format::TAR:
+                    tar::load(idx, result->hotfixes, token);
+                    break;
+                case Format::V2:
+                    v2::load(idx, result->hotfixes, token);
+                    break;
+                case Format::NONE:
+                default:
+                    throw std::runtime_error("No hfdat file loaded");
+            }
+        }
+
+        if (use_disk_cache) {
+            disk_cache::store(name, result->hotfixes);
+        }
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << std::format("[dhf] {} {} hotfixes ({} KiB) from '{}' in {:.1f}ms\n",
+                             from_disk_cache ? "Mapped" : "Loaded", result->hotfixes.size(),
+                             // NOLINTNEXTLINE(readability-magic-numbers)
+                             result->hotfixes.memory_usage() / 1024, name, duration.count());
+
+    return result;
+}
+
+/**
+ * @brief Marks a load as finished.
+ *
+ * @param load The load to mark.
+ */
+void finish_load(AsyncLoad& load) {
+    load.progress.store(1.0F, std::memory_order_relaxed);
+    load.finished.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Runs a load, storing the hotfixes on the load object.
+ * @note File loads always decode the set, the cache should be checked beforehand.
+ *
+ * @param load The load to run.
+ * @param token The token to report progress and check for cancellation with.
+ */
+void run_load(AsyncLoad& load, const LoadToken& token) {
+    try {
+        if (load.type != LoadType::FILE) {
+            load.result = std::make_shared<const LoadedHotfixes>(
+                load.name, load.type == LoadType::CURRENT, HotfixSet{});
+        } else {
+            auto result = load_from_file(load.name, token);
+            add_to_cache(result);
+            load.result = std::move(result);
+        }
+    } catch (const LoadCancelled&) {
+    } catch (const std::exception& ex) {
+        std::cerr << "[dhf] Failed to read hotfix file '" << load.name
+                  << "' from archive: " << ex.what() << "\n";
+    }
+
+    finish_load(load);
+}
+
+/**
+ * @brief Makes the hotfixes from a finished load active.
+ * @note Leaves the previous hotfixes active if the load failed.
+ *
+ * @param load The load to apply.
+ */
+void apply_load(const AsyncLoad& load) {
+    if (load.result == nullptr) {
+        return;
+    }
+    loaded_hotfixes.store(load.result);
+}
+
+}  // namespace
+
+const std::vector<std::string>& hotfix_names = hotfix_names_internal;
+const std::vector<SetInfo>& hotfix_info = hotfix_info_internal;
+const std::string& hfdat_name = hfdat_name_internal;
+
+std::shared_ptr<const LoadedHotfixes> get_loaded_hotfixes(void) {
+    return loaded_hotfixes.load();
+}
+
+void set_loaded_hotfixes(std::shared_ptr<const LoadedHotfixes> hotfixes) {
+    if (hotfixes == nullptr) {
+        throw std::invalid_argument("Loaded hotfixes may not be null");
+    }
+    loaded_hotfixes.store(std::move(hotfixes));
+}
+
+void init(void) {
+    std::filesystem::path hfdat_path;
+    for (const auto& dir_entry :
+         std::filesystem::directory_iterator{settings::dll_path.parent_path()}) {
+        auto& path = dir_entry.path();
+        if (!dir_entry.is_directory() && path.extension() == ".hfdat") {
+            hfdat_path = path;
+            break;
+        }
+    }
+
+    if (!std::filesystem::exists(hfdat_path)) {
+        return;
+    }
+    hfdat_name_internal = hfdat_path.filename().generic_string();
+
+    if (v2::is_v2(hfdat_path)) {
+        hfdat_format = Format::V2;
+        hotfix_names_internal = v2::init(hfdat_path);
+        hotfix_info_internal = v2::get_set_info();
+    } else {
+        hfdat_format = Format::TAR;
+        hotfix_names_internal = tar::init(hfdat_path);
+        hotfix_info_internal = tar::get_set_info();
+    }
+    // Archives without a table of contents don't have any info, but still need an entry per set
+    hotfix_info_internal.resize(hotfix_names_internal.size());
+
+    use_disk_cache = hfdat_format != Format::V2 || !v2::uses_string_pool();
+    if (use_disk_cache) {
+        disk_cache::init(hfdat_path);
+    }
+}
+
+std::shared_ptr<const AsyncLoad> load_new_hotfixes_async(const std::string& name, LoadType type) {
+    auto load = std::make_shared<AsyncLoad>(name, type);
+
+    {
+        const std::lock_guard<std::mutex> lock{pending_load_mutex};
+        if (pending_load != nullptr) {
+            pending_load->stop.request_stop();
+        }
+        pending_load = load;
+    }
+
+    // Only file loads which miss the cache actually need to do any work
+    if (type != LoadType::FILE) {
+        run_load(*load, {});
+        return load;
+    }
+    if (auto cached = find_cached(name); cached != nullptr) {
+        load->result = std::move(cached);
+        finish_load(*load);
+        return load;
+    }
+
+    std::thread{[load]() {
+        run_load(*load, {load->stop.get_token(), &load->progress});
+    }}.detach();
+
+    return load;
+}
+
+CacheStats get_cache_stats(void) {
+    const std::lock_guard<std::mutex> lock{cache_mutex};
+    return cache_stats;
+}
+
+void set_cache_budget(size_t budget_bytes) {
+    const std::lock_guard<std::mutex> lock{cache_mutex};
+    cache_stats.budget_bytes = budget_bytes;
+    evict_to_budget();
+}
+
+void update_pending_load(void) {
+    const std::lock_guard<std::mutex> lock{pending_load_mutex};
+    if (pending_load == nullptr || !pending_load->finished.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    apply_load(*pending_load);
+    pending_load = nullptr;
+}
+
+}  // namespace dhf::hfdat
@@ -0,0 +1,152 @@
+#ifndef HFDAT_HFDAT_H
+#define HFDAT_HFDAT_H
+
+#include "pch.h"
+
+#include "hfdat/hotfix_set.h"
+
+namespace dhf::hfdat {
+
+/// A list of all the loaded hotfix file names (including ordering chars).
+extern const std::vector<std::string>& hotfix_names;
+
+/**
+ * @brief Struct holding the metadata the hfdat's catalog stores about a set of hotfixes.
+ * @note Read when the hfdat is first loaded, so is available without decompressing the set. Any
+ *       field the hfdat doesn't store is left empty.
+ */
+struct SetInfo {
+    /// The amount of hotfixes in the set.
+    std::optional<uint32_t> num_hotfixes;
+    /// How many bytes the set takes up in the hfdat.
+    std::optional<uint64_t> stored_size;
+    /// The combined length of every key and value, in wchars.
+    std::optional<uint64_t> num_chars;
+    /// When the hotfixes were originally released.
+    std::optional<std::chrono::sys_seconds> released;
+    /// The crc32 of every key and value in the set, see `hotfixes::predict_hotfix_hash`.
+    std::optional<uint32_t> content_hash;
+};
+
+/// The metadata of each set of hotfixes, in the same order as their names.
+extern const std::vector<SetInfo>& hotfix_info;
+
+/// The name of the hfdat file hotfixes were loaded from.
+extern const std::string& hfdat_name;
+
+/**
+ * @brief An immutable snapshot of a loaded set of hotfixes.
+ */
+struct LoadedHotfixes {
+    /// The full name of the loaded hotfixes.
+    std::string name;
+    /// True if to use current hotfixes, rather than try overwriting.
+    bool use_current;
+    /// The custom hotfixes to load.
+    HotfixSet hotfixes;
+};
+
+/**
+ * @brief Gets the currently loaded hotfixes.
+ * @note Thread safe. The returned snapshot stays valid even if new hotfixes get loaded while it's
+ *       being used, it's only freed once the last reader releases it.
+ *
+ * @return The current snapshot. Never null.
+ */
+[[nodiscard]] std::shared_ptr<const LoadedHotfixes> get_loaded_hotfixes(void);
+
+/**
+ * @brief Makes a set of hotfixes active straight away, without loading it from the hfdat.
+ * @note Thread safe. Meant for running outside of the game, where there may not be an hfdat.
+ *
+ * @param hotfixes The snapshot to make active. May not be null.
+ */
+void set_loaded_hotfixes(std::shared_ptr<const LoadedHotfixes> hotfixes);
+
+/**
+ * @brief Finds and loads the inital hotfix metadata.
+ */
+void init(void);
+
+enum class LoadType {
+    FILE,
+    CURRENT,
+    NONE,
+};
+
+/**
+ * @brief Struct holding the state of a hotfix load running in the background.
+ */
+struct AsyncLoad {
+    /// The full name of the hotfixes being loaded.
+    const std::string name;
+    /// What type of load is being performed.
+    const LoadType type;
+
+    /// How far through the load we are, between 0 and 1.
+    std::atomic<float> progress = 0.0F;
+    /// Set once the load has finished, whether it succeeded or not.
+    std::atomic<bool> finished = false;
+    /// Stop source used to cancel the load.
+    std::stop_source stop;
+
+    /// The loaded hotfixes, or null if the load failed. Only valid once finished.
+    std::shared_ptr<const LoadedHotfixes> result;
+
+    AsyncLoad(std::string name, LoadType type) : name(std::move(name)), type(type) {}
+};
+
+/**
+ * @brief Starts loading a new hotfix file on a worker thread.
+ * @note Cancels any previous load which is still running.
+ * @note The currently loaded hotfixes stay active until `update_pending_load` is called after the
+ *       new ones have finished loading.
+ *
+ * @param name The full name of the hotfixes to load.
+ * @param type What type of load to perform.
+ * @return A handle which may be used to poll the load's progress.
+ */
+std::shared_ptr<const AsyncLoad> load_new_hotfixes_async(const std::string& name,
+                                                         LoadType type = LoadType::FILE);
+
+/**
+ * @brief Checks if the pending background load has finished, and if so makes it's hotfixes active.
+ * @note Intended to be called every frame.
+ */
+void update_pending_load(void);
+
+/**
+ * @brief Struct holding statistics about the decoded set cache.
+ */
+struct CacheStats {
+    /// How many file loads were served straight out of the cache.
+    uint64_t hits;
+    /// How many file loads had to decode the set from the hfdat.
+    uint64_t misses;
+    /// The amount of sets currently held in the cache.
+    size_t num_sets;
+    /// How much memory the cached sets take up, in bytes.
+    size_t resident_bytes;
+    /// The maximum amount of memory the cached sets may take up, in bytes.
+    size_t budget_bytes;
+};
+
+/**
+ * @brief Gets statistics about the decoded set cache.
+ * @note Thread safe.
+ *
+ * @return The current statistics.
+ */
+[[nodiscard]] CacheStats get_cache_stats(void);
+
+/**
+ * @brief Sets how much memory the decoded set cache may take up, evicting sets if needed.
+ * @note Thread safe. A budget of 0 disables the cache.
+ *
+ * @param budget_bytes The new budget, in bytes.
+ */
+void set_cache_budget(size_t budget_bytes);
+
+}  // namespace dhf::hfdat
+
+#endif /* HFDAT_HFDAT_H */
@@ -0,0 +1,321 @@
+#include "pch.h"
+
+#include "hfdat/hotfix_set.h"
+#include "hfdat/latin1.h"
+
+namespace dhf::hfdat {
+
+namespace {
+
+const constexpr uint8_t UTF8_ASCII_LIMIT = 0x80;
+const constexpr uint8_t UTF8_CONTINUATION_MASK = 0xC0;
+const constexpr uint8_t UTF8_CONTINUATION = 0x80;
+const constexpr uint8_t UTF8_CONTINUATION_BITS = 6;
+const constexpr uint32_t MAX_CODE_POINT = 0x10FFFF;
+const constexpr uint32_t MAX_BMP_CODE_POINT = 0xFFFF;
+const constexpr uint32_t SURROGATE_OFFSET = 0x10000;
+const constexpr uint32_t HIGH_SURROGATE_START = 0xD800;
+const constexpr uint32_t LOW_SURROGATE_START = 0xDC00;
+const constexpr uint32_t SURROGATE_BITS = 10;
+const constexpr uint32_t SURROGATE_MASK = 0x3FF;
+
+/**
+ * @brief Describes each kind of utf8 lead byte.
+ */
+struct Utf8Lead {
+    uint8_t mask;
+    uint8_t value;
+    size_t num_continuations;
+    // The smallest code point which needs this many bytes, anything lower is overlong
+    uint32_t min_code_point;
+};
+const constexpr std::array<Utf8Lead, 3> UTF8_LEADS{{
+    {0xE0, 0xC0, 1, 0x80},
+    {0xF0, 0xE0, 2, 0x800},
+    {0xF8, 0xF0, 3, 0x10000},
+}};
+
+/**
+ * @brief Decodes a utf8 string into wide chars.
+ * @note Throws a runtime error if the string isn't valid utf8.
+ *
+ * @param str Pointer to the string's utf8 bytes.
+ * @param len The length of the string, in bytes.
+ * @return The decoded string.
+ */
+std::wstring decode_utf8(const uint8_t* str, size_t len) {
+    std::wstring out;
+    out.reserve(len);
+
+    size_t pos = 0;
+    while (pos < len) {
+        auto lead = str[pos++];
+        if (lead < UTF8_ASCII_LIMIT) {
+            out.push_back((wchar_t)lead);
+            continue;
+        }
+
+        const auto* kind = std::ranges::find_if(UTF8_LEADS, [lead](const auto& candidate) {
+            return (lead & candidate.mask) == candidate.value;
+        });
+        if (kind == UTF8_LEADS.end() || kind->num_continuations > len - pos) {
+            throw std::runtime_error("String has invalid utf8");
+        }
+
+        uint32_t code_point = lead & (uint8_t)~kind->mask;
+        for (size_t i = 0; i < kind->num_continuations; i++) {
+            auto byte = str[pos++];
+            if ((byte & UTF8_CONTINUATION_MASK) != UTF8_CONTINUATION) {
+                throw std::runtime_error("String has invalid utf8");
+            }
+            code_point = (code_point << UTF8_CONTINUATION_BITS)
+                         | (byte & (uint8_t)~UTF8_CONTINUATION_MASK);
+        }
+        if (code_point < kind->min_code_point || code_point > MAX_CODE_POINT) {
+            throw std::runtime_error("String has invalid utf8");
+        }
+
+        if constexpr (sizeof(wchar_t) == sizeof(uint16_t)) {
+            if (code_point > MAX_BMP_CODE_POINT) {
+                code_point -= SURROGATE_OFFSET;
+                out.push_back((wchar_t)(HIGH_SURROGATE_START + (code_point >> SURROGATE_BITS)));
+                out.push_back((wchar_t)(LOW_SURROGATE_START + (code_point & SURROGATE_MASK)));
+                continue;
+            }
+        }
+        out.push_back((wchar_t)code_point);
+    }
+
+    return out;
+}
+
+}  // namespace
+
+void PooledString::copy_to(wchar_t* dest) const {
+    if (this->wide) {
+        memcpy(dest, this->str, this->len * sizeof(wchar_t));
+    } else {
+        latin1::widen(this->str, this->len, dest);
+    }
+    dest[this->len] = L'\0';
+}
+
+std::wstring PooledString::to_wstr(void) const {
+    std::wstring out(this->len, L'\0');
+    this->copy_to(out.data());
+    return out;
+}
+
+StringPool::StringPool(size_t max_strings, size_t max_chars) : max_strings(max_strings) {
+    if (max_chars >= WIDE_FLAG / sizeof(wchar_t)
+        || max_strings > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("String pool is too large");
+    }
+    this->max_bytes = max_chars * sizeof(wchar_t);
+
+    auto offsets_size = (max_strings + 1) * sizeof(uint32_t);
+    this->arena_size = offsets_size + this->max_bytes;
+    auto arena = std::make_shared_for_overwrite<std::byte[]>(this->arena_size);
+
+    // Offsets go first, since they have the stricter alignment
+    this->writable_offsets = reinterpret_cast<uint32_t*>(arena.get());
+    this->writable_bytes = reinterpret_cast<uint8_t*>(arena.get() + offsets_size);
+    this->writable_offsets[0] = 0;
+
+    this->offsets = this->writable_offsets;
+    this->bytes = this->writable_bytes;
+    this->owner = std::move(arena);
+}
+
+StringPool::StringPool(std::shared_ptr<const void> owner,
+                       const uint32_t* offsets,
+                       const uint8_t* bytes,
+                       size_t num_strings)
+    : owner(std::move(owner)),
+      arena_size(((num_strings + 1) * sizeof(uint32_t)) + (offsets[num_strings] & ~WIDE_FLAG)),
+      offsets(offsets),
+      bytes(bytes),
+      num_strings(num_strings),
+      max_strings(num_strings),
+      max_bytes(offsets[num_strings] & ~WIDE_FLAG) {}
+
+StringPool::StringPool(StringPool&& other) noexcept {
+    *this = std::move(other);
+}
+
+StringPool& StringPool::operator=(StringPool&& other) noexcept {
+    this->owner = std::move(other.owner);
+    this->arena_size = std::exchange(other.arena_size, 0);
+    this->offsets = std::exchange(other.offsets, nullptr);
+    this->bytes = std::exchange(other.bytes, nullptr);
+    this->writable_offsets = std::exchange(other.writable_offsets, nullptr);
+    this->writable_bytes = std::exchange(other.writable_bytes, nullptr);
+    this->num_strings = std::exchange(other.num_strings, 0);
+    this->max_strings = std::exchange(other.max_strings, 0);
+    this->max_bytes = std::exchange(other.max_bytes, 0);
+    return *this;
+}
+
+uint32_t StringPool::get_next_start(size_t len) const {
+    if (this->writable_offsets == nullptr) {
+        throw std::logic_error("Can't add strings to a read only pool");
+    }
+    if (this->num_strings >= this->max_strings) {
+        throw std::runtime_error("More strings than expected");
+    }
+
+    auto start = this->offsets[this->num_strings] & ~WIDE_FLAG;
+    if (len > (this->max_bytes - start) / sizeof(wchar_t)) {
+        throw std::runtime_error("Strings are larger than expected");
+    }
+    return start;
+}
+
+void StringPool::push_back(const void* str, size_t len) {
+    auto start = this->get_next_start(len);
+
+    auto* dest = &this->writable_bytes[start];
+    auto end = start + (uint32_t)len;
+    if (!latin1::narrow(str, len, dest)) {
+        memcpy(dest, str, len * sizeof(wchar_t));
+        end = (start + (uint32_t)(len * sizeof(wchar_t))) | WIDE_FLAG;
+    }
+    this->writable_offsets[++this->num_strings] = end;
+}
+
+void StringPool::push_back_utf8(const uint8_t* str, size_t len) {
+    // Ascii is a subset of Latin-1, so the vast majority of strings can be stored as is
+    if (std::all_of(str, str + len, [](uint8_t byte) { return byte < UTF8_ASCII_LIMIT; })) {
+        auto start = this->get_next_start(len);
+        memcpy(&this->writable_bytes[start], str, len);
+        this->writable_offsets[++this->num_strings] = start + (uint32_t)len;
+        return;
+    }
+
+    auto decoded = decode_utf8(str, len);
+    this->push_back(decoded.data(), decoded.size());
+}
+
+void StringPool::shrink_to_fit(void) {
+    if (this->writable_offsets == nullptr) {
+        return;
+    }
+
+    auto offsets_size = (this->num_strings + 1) * sizeof(uint32_t);
+    auto used_bytes = (size_t)(this->offsets[this->num_strings] & ~WIDE_FLAG);
+
+    this->arena_size = offsets_size + used_bytes;
+    auto arena = std::make_shared_for_overwrite<std::byte[]>(this->arena_size);
+    memcpy(arena.get(), this->offsets, offsets_size);
+    memcpy(arena.get() + offsets_size, this->bytes, used_bytes);
+
+    this->offsets = reinterpret_cast<const uint32_t*>(arena.get());
+    this->bytes = reinterpret_cast<const uint8_t*>(arena.get() + offsets_size);
+    this->writable_offsets = nullptr;
+    this->writable_bytes = nullptr;
+    this->max_strings = this->num_strings;
+    this->max_bytes = used_bytes;
+    this->owner = std::move(arena);
+}
+
+HotfixSet::HotfixSet(size_t num_hotfixes, size_t max_chars)
+    : max_hotfixes(num_hotfixes) {
+    if (num_hotfixes > std::numeric_limits<size_t>::max() / 2) {
+        throw std::runtime_error("Set is too large");
+    }
+    this->strings = StringPool{num_hotfixes * 2, max_chars};
+}
+
+HotfixSet::HotfixSet(std::shared_ptr<const StringPool> pool, size_t num_hotfixes)
+    : shared_pool(std::move(pool)), max_hotfixes(num_hotfixes) {
+    if (this->shared_pool == nullptr) {
+        throw std::invalid_argument("Shared string pool may not be null");
+    }
+    if (num_hotfixes > std::numeric_limits<size_t>::max() / sizeof(uint32_t) / 2) {
+        throw std::runtime_error("Set is too large");
+    }
+    this->ids = std::make_unique_for_overwrite<uint32_t[]>(num_hotfixes * 2);
+}
+
+HotfixSet::HotfixSet(StringPool&& strings)
+    : strings(std::move(strings)),
+      num_hotfixes(this->strings.size() / 2),
+      max_hotfixes(this->num_hotfixes) {
+    if (this->strings.size() % 2 != 0) {
+        throw std::runtime_error("Set has a key without a value");
+    }
+}
+
+HotfixSet::HotfixSet(HotfixSet&& other) noexcept {
+    *this = std::move(other);
+}
+
+HotfixSet& HotfixSet::operator=(HotfixSet&& other) noexcept {
+    this->strings = std::move(other.strings);
+    this->shared_pool = std::move(other.shared_pool);
+    this->ids = std::move(other.ids);
+    this->num_hotfixes = std::exchange(other.num_hotfixes, 0);
+    this->max_hotfixes = std::exchange(other.max_hotfixes, 0);
+    return *this;
+}
+
+void HotfixSet::push_back(const void* key, size_t key_len, const void* value, size_t value_len) {
+    if (this->shared_pool != nullptr) {
+        throw std::logic_error("Can't add strings to a set using a shared pool");
+    }
+    if (this->num_hotfixes >= this->max_hotfixes) {
+        throw std::runtime_error("Set has more hotfixes than expected");
+    }
+
+    this->strings.push_back(key, key_len);
+    this->strings.push_back(value, value_len);
+    this->num_hotfixes++;
+}
+
+void HotfixSet::push_back_utf8(const uint8_t* key,
+                               size_t key_len,
+                               const uint8_t* value,
+                               size_t value_len) {
+    if (this->shared_pool != nullptr) {
+        throw std::logic_error("Can't add strings to a set using a shared pool");
+    }
+    if (this->num_hotfixes >= this->max_hotfixes) {
+        throw std::runtime_error("Set has more hotfixes than expected");
+    }
+
+    this->strings.push_back_utf8(key, key_len);
+    this->strings.push_back_utf8(value, value_len);
+    this->num_hotfixes++;
+}
+
+void HotfixSet::push_back(uint32_t key_id, uint32_t value_id) {
+    if (this->shared_pool == nullptr) {
+        throw std::logic_error("Can't add string ids to a set without a shared pool");
+    }
+    if (this->num_hotfixes >= this->max_hotfixes) {
+        throw std::runtime_error("Set has more hotfixes than expected");
+    }
+    if (key_id >= this->shared_pool->size() || value_id >= this->shared_pool->size()) {
+        throw std::runtime_error("Set refers to strings outside of the pool");
+    }
+
+    this->ids[this->num_hotfixes * 2] = key_id;
+    this->ids[(this->num_hotfixes * 2) + 1] = value_id;
+    this->num_hotfixes++;
+}
+
+void HotfixSet::shrink_to_fit(void) {
+    if (this->shared_pool == nullptr) {
+        this->strings.shrink_to_fit();
+        this->max_hotfixes = this->num_hotfixes;
+    }
+}
+
+size_t HotfixSet::memory_usage(void) const {
+    if (this->shared_pool == nullptr) {
+        return this->strings.memory_usage();
+    }
+    return this->max_hotfixes * 2 * sizeof(uint32_t);
+}
+
+}  // namespace dhf::hfdat
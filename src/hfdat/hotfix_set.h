@@ -0,0 +1,367 @@
+#ifndef HFDAT_HOTFIX_SET_H
+#define HFDAT_HOTFIX_SET_H
+
+#include "pch.h"
+
+namespace dhf::hfdat {
+
+/**
+ * @brief A view of a string stored in a pool.
+ * @note Strings are stored as Latin-1 wherever possible, so this may need widening before it can
+ *       be used as a wide string.
+ */
+class PooledString {
+   public:
+    PooledString(const uint8_t* data, size_t len, bool wide) : str(data), len(len), wide(wide) {}
+
+    /**
+     * @brief Gets the length of the string.
+     *
+     * @return The length, in characters.
+     */
+    [[nodiscard]] size_t size(void) const { return this->len; }
+
+    /**
+     * @brief Checks if the string is empty.
+     *
+     * @return True if the string is empty.
+     */
+    [[nodiscard]] bool empty(void) const { return this->len == 0; }
+
+    /**
+     * @brief Checks if the string is stored as wide chars, rather than as Latin-1.
+     *
+     * @return True if the string is wide.
+     */
+    [[nodiscard]] bool is_wide(void) const { return this->wide; }
+
+    /**
+     * @brief Gets the raw stored bytes of the string.
+     * @note Wide strings may be unaligned.
+     *
+     * @return A pointer to the string's bytes.
+     */
+    [[nodiscard]] const uint8_t* data(void) const { return this->str; }
+
+    /**
+     * @brief Gets the size of the raw stored bytes of the string.
+     *
+     * @return The size, in bytes.
+     */
+    [[nodiscard]] size_t byte_size(void) const {
+        return this->wide ? this->len * sizeof(wchar_t) : this->len;
+    }
+
+    /**
+     * @brief Copies the string into a wide char buffer, followed by a null terminator.
+     *
+     * @param dest The buffer to copy into, at least `size() + 1` chars long.
+     */
+    void copy_to(wchar_t* dest) const;
+
+    /**
+     * @brief Copies the string into a new wstring.
+     *
+     * @return The new string.
+     */
+    [[nodiscard]] std::wstring to_wstr(void) const;
+
+   private:
+    const uint8_t* str;
+    size_t len;
+    bool wide;
+};
+
+/**
+ * @brief A list of strings, addressed by index.
+ * @note All strings are stored back to back in a single arena, alongside an array of offsets into
+ *       it, so the whole pool only takes one allocation. Alternatively, a pool may be a read only
+ *       view of the same layout in memory owned by something else, e.g. a mapped file.
+ * @note Strings which fit in Latin-1 are stored narrowed to one byte per char, only the rare ones
+ *       which don't are stored wide. Strings are not null terminated.
+ */
+class StringPool {
+   public:
+    // Set on the end offset of strings which are stored wide
+    static const constexpr uint32_t WIDE_FLAG = 0x80000000;
+
+    StringPool(void) = default;
+
+    /**
+     * @brief Allocates a new, empty, pool.
+     * @note Throws a runtime error if the pool is too large to be addressed.
+     * @note Makes space for every string being wide, call `shrink_to_fit` once done to release
+     *       whatever ended up unused.
+     *
+     * @param max_strings The maximum amount of strings the pool will hold.
+     * @param max_chars The maximum combined length of all strings, in characters. A utf8 length
+     *                  in bytes is never smaller, so may be used instead.
+     */
+    StringPool(size_t max_strings, size_t max_chars);
+
+    /**
+     * @brief Creates a read only pool viewing existing memory.
+     * @note The caller is responsible for validating the offsets.
+     *
+     * @param owner The object owning the memory, kept alive for as long as the pool is.
+     * @param offsets The offsets array, of `num_strings + 1` entries.
+     * @param bytes The stored bytes of all strings.
+     * @param num_strings The amount of strings.
+     */
+    StringPool(std::shared_ptr<const void> owner,
+               const uint32_t* offsets,
+               const uint8_t* bytes,
+               size_t num_strings);
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    StringPool(StringPool&& other) noexcept;
+    StringPool& operator=(StringPool&& other) noexcept;
+    ~StringPool() = default;
+
+    /**
+     * @brief Appends a new string to the pool.
+     * @note Throws a runtime error if there's no space left for it.
+     *
+     * @param str Pointer to the string's characters. Needn't be aligned.
+     * @param len The length of the string, in characters.
+     */
+    void push_back(const void* str, size_t len);
+
+    /**
+     * @brief Appends a new utf8 encoded string to the pool.
+     * @note Throws a runtime error if there's no space left for it, or if it's not valid utf8.
+     * @note Lone surrogates are allowed, so that any wide string can make it through.
+     *
+     * @param str Pointer to the string's utf8 bytes.
+     * @param len The length of the string, in bytes.
+     */
+    void push_back_utf8(const uint8_t* str, size_t len);
+
+    /**
+     * @brief Moves the strings into a new arena of exactly the size they need.
+     * @note Does nothing on read only pools. The pool may not be added to afterwards.
+     */
+    void shrink_to_fit(void);
+
+    /**
+     * @brief Gets the amount of strings in the pool.
+     *
+     * @return The amount of strings.
+     */
+    [[nodiscard]] size_t size(void) const { return this->num_strings; }
+
+    /**
+     * @brief Gets a string out of the pool.
+     * @note Throws an out of range error if the index is invalid.
+     *
+     * @param idx The index of the string.
+     * @return A view of the string, valid for as long as the pool is.
+     */
+    [[nodiscard]] PooledString operator[](size_t idx) const {
+        if (idx >= this->num_strings) {
+            throw std::out_of_range("String index out of range");
+        }
+        auto start = this->offsets[idx] & ~WIDE_FLAG;
+        auto end = this->offsets[idx + 1];
+        auto wide = (end & WIDE_FLAG) != 0;
+        auto byte_len = (end & ~WIDE_FLAG) - start;
+        return {&this->bytes[start], wide ? byte_len / sizeof(wchar_t) : byte_len, wide};
+    }
+
+    /**
+     * @brief Gets how much memory the pool's arena takes up.
+     *
+     * @return The size of the arena, in bytes.
+     */
+    [[nodiscard]] size_t memory_usage(void) const { return this->arena_size; }
+
+   private:
+    // Keeps the memory alive, either our own arena or whatever we're viewing
+    std::shared_ptr<const void> owner;
+    size_t arena_size = 0;
+
+    // String `i` spans bytes `offsets[i]` to `offsets[i + 1]`, ignoring the wide flag, which is set
+    //  on `offsets[i + 1]` if it's stored wide
+    const uint32_t* offsets = nullptr;
+    const uint8_t* bytes = nullptr;
+
+    // Only set when we own the arena, the same memory as above but writable
+    uint32_t* writable_offsets = nullptr;
+    uint8_t* writable_bytes = nullptr;
+
+    size_t num_strings = 0;
+    size_t max_strings = 0;
+    size_t max_bytes = 0;
+
+    /**
+     * @brief Checks there's space to add another string, and gets where it should start.
+     * @note Throws if there isn't space, assuming the string might need to be stored wide.
+     *
+     * @param len The length of the string, in characters.
+     * @return The byte offset the string should start at.
+     */
+    [[nodiscard]] uint32_t get_next_start(size_t len) const;
+};
+
+/**
+ * @brief A decoded set of hotfixes.
+ * @note A set either stores it's own keys and values, in a single arena, or refers to them by
+ *       index in a string pool shared with other sets.
+ */
+class HotfixSet {
+   public:
+    HotfixSet(void) = default;
+
+    /**
+     * @brief Allocates a new, empty, set which stores it's own strings.
+     * @note Throws a runtime error if the set is too large to be addressed.
+     *
+     * @param num_hotfixes The amount of hotfixes the set will hold.
+     * @param max_chars The maximum combined length of all keys and values, in characters. A utf8
+     *                  length in bytes is never smaller, so may be used instead.
+     */
+    HotfixSet(size_t num_hotfixes, size_t max_chars);
+
+    /**
+     * @brief Allocates a new, empty, set which refers to strings in a shared pool.
+     *
+     * @param pool The pool holding all the set's keys and values.
+     * @param num_hotfixes The amount of hotfixes the set will hold.
+     */
+    HotfixSet(std::shared_ptr<const StringPool> pool, size_t num_hotfixes);
+
+    /**
+     * @brief Creates a full set out of an existing pool of it's own strings.
+     * @note Throws a runtime error if the pool doesn't hold a whole number of hotfixes.
+     *
+     * @param strings The set's keys and values, alternating.
+     */
+    explicit HotfixSet(StringPool&& strings);
+
+    HotfixSet(const HotfixSet&) = delete;
+    HotfixSet& operator=(const HotfixSet&) = delete;
+    HotfixSet(HotfixSet&& other) noexcept;
+    HotfixSet& operator=(HotfixSet&& other) noexcept;
+    ~HotfixSet() = default;
+
+    /**
+     * @brief Appends a new hotfix to a set storing it's own strings.
+     * @note Throws a runtime error if there's no space left for it.
+     *
+     * @param key Pointer to the key's characters. Needn't be aligned.
+     * @param key_len The length of the key, in characters.
+     * @param value Pointer to the value's characters. Needn't be aligned.
+     * @param value_len The length of the value, in characters.
+     */
+    void push_back(const void* key, size_t key_len, const void* value, size_t value_len);
+
+    /**
+     * @brief Appends a new utf8 encoded hotfix to a set storing it's own strings.
+     * @note Throws a runtime error if there's no space left for it, or if it's not valid utf8.
+     *
+     * @param key Pointer to the key's utf8 bytes.
+     * @param key_len The length of the key, in bytes.
+     * @param value Pointer to the value's utf8 bytes.
+     * @param value_len The length of the value, in bytes.
+     */
+    void push_back_utf8(const uint8_t* key,
+                        size_t key_len,
+                        const uint8_t* value,
+                        size_t value_len);
+
+    /**
+     * @brief Appends a new hotfix to a set using a shared pool.
+     * @note Throws a runtime error if there's no space left for it, or if the ids are invalid.
+     *
+     * @param key_id The index of the key in the pool.
+     * @param value_id The index of the value in the pool.
+     */
+    void push_back(uint32_t key_id, uint32_t value_id);
+
+    /**
+     * @brief Releases any space a set storing it's own strings didn't end up using.
+     * @note The set may not be added to afterwards.
+     */
+    void shrink_to_fit(void);
+
+    /**
+     * @brief Gets the amount of hotfixes in the set.
+     *
+     * @return The amount of hotfixes.
+     */
+    [[nodiscard]] size_t size(void) const { return this->num_hotfixes; }
+
+    /**
+     * @brief Checks if the set contains no hotfixes.
+     *
+     * @return True if the set is empty.
+     */
+    [[nodiscard]] bool empty(void) const { return this->num_hotfixes == 0; }
+
+    /**
+     * @brief Gets a hotfix's key.
+     *
+     * @param idx The index of the hotfix.
+     * @return A view of the key, valid for as long as the set is.
+     */
+    [[nodiscard]] PooledString key(size_t idx) const { return this->get_str(idx * 2); }
+
+    /**
+     * @brief Gets a hotfix's value.
+     *
+     * @param idx The index of the hotfix.
+     * @return A view of the value, valid for as long as the set is.
+     */
+    [[nodiscard]] PooledString value(size_t idx) const { return this->get_str((idx * 2) + 1); }
+
+    /**
+     * @brief Gets a hotfix's key and value.
+     *
+     * @param idx The index of the hotfix.
+     * @return A pair of views of the key and value, valid for as long as the set is.
+     */
+    [[nodiscard]] std::pair<PooledString, PooledString> operator[](size_t idx) const {
+        return {this->key(idx), this->value(idx)};
+    }
+
+    /**
+     * @brief Gets how much memory the set takes up.
+     * @note Doesn't include the shared pool, if the set uses one.
+     *
+     * @return The size of the set's own allocations, in bytes.
+     */
+    [[nodiscard]] size_t memory_usage(void) const;
+
+   private:
+    // Keys are stored at even indexes, values at odd ones
+    StringPool strings;
+
+    // If set, `ids` hold the index of each key and value in the shared pool instead
+    std::shared_ptr<const StringPool> shared_pool;
+    std::unique_ptr<uint32_t[]> ids;
+
+    size_t num_hotfixes = 0;
+    size_t max_hotfixes = 0;
+
+    /**
+     * @brief Gets one of the set's keys or values.
+     *
+     * @param str_idx The index of the string, keys at even indexes, values at odd ones.
+     * @return A view of the string.
+     */
+    [[nodiscard]] PooledString get_str(size_t str_idx) const {
+        if (this->shared_pool == nullptr) {
+            return this->strings[str_idx];
+        }
+
+        if (str_idx >= this->num_hotfixes * 2) {
+            throw std::out_of_range("Hotfix index out of range");
+        }
+        return (*this->shared_pool)[this->ids[str_idx]];
+    }
+};
+
+}  // namespace dhf::hfdat
+
+#endif /* HFDAT_HOTFIX_SET_H */
@@ -0,0 +1,195 @@
+#include "pch.h"
+
+#include "hfdat/latin1.h"
+
+// MSVC allows AVX2 intrinsics anywhere, clang and gcc need the functions using them to opt in
+#if defined(__clang__) || defined(__GNUC__)
+#define TARGET_AVX2 [[gnu::target("avx2")]]
+#else
+#define TARGET_AVX2
+#endif
+
+namespace dhf::hfdat::latin1 {
+
+namespace {
+
+// The vectorized paths all assume two byte chars, which is always the case on Windows
+const constexpr bool SIMD_SUPPORTED = sizeof(wchar_t) == sizeof(uint16_t);
+
+const constexpr size_t SSE2_CHARS = sizeof(__m128i);
+const constexpr size_t AVX2_CHARS = sizeof(__m256i);
+
+const constexpr int16_t NON_LATIN1_MASK = (int16_t)0xFF00;
+const constexpr uint32_t ALL_LANES_SET = 0xFFFF;
+// Swaps the middle two qwords, undoing the per lane interleaving of `_mm256_packus_epi16`
+const constexpr int PACK_FIXUP_ORDER = 0b11'01'10'00;
+
+/**
+ * @brief Checks if the cpu and os both support AVX2.
+ * @note Older Windows SDKs don't define the feature flag, in which case we stick to SSE2.
+ *
+ * @return True if AVX2 instructions are safe to use.
+ */
+bool has_avx2(void) {
+#ifdef PF_AVX2_INSTRUCTIONS_AVAILABLE
+    return IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE) != 0;
+#else
+    return false;
+#endif
+}
+
+const bool use_avx2 = has_avx2();
+
+/**
+ * @brief Narrows as much of a string as possible, one char at a time.
+ *
+ * @param src Pointer to the string's characters.
+ * @param len The length of the string, in characters.
+ * @param dest The buffer to write to.
+ * @return True if the whole string fit in Latin-1.
+ */
+bool narrow_scalar(const uint8_t* src, size_t len, uint8_t* dest) {
+    for (size_t i = 0; i < len; i++) {
+        wchar_t chr{};
+        memcpy(&chr, &src[i * sizeof(wchar_t)], sizeof(chr));
+        if ((uint32_t)chr > std::numeric_limits<uint8_t>::max()) {
+            return false;
+        }
+        dest[i] = (uint8_t)chr;
+    }
+    return true;
+}
+
+/**
+ * @brief Widens as much of a string as possible, one char at a time.
+ *
+ * @param src The Latin-1 characters.
+ * @param len The length of the string, in characters.
+ * @param dest The buffer to write to.
+ */
+void widen_scalar(const uint8_t* src, size_t len, wchar_t* dest) {
+    for (size_t i = 0; i < len; i++) {
+        dest[i] = (wchar_t)src[i];
+    }
+}
+
+/**
+ * @brief Narrows the start of a string, 16 chars at a time.
+ *
+ * @param src Pointer to the string's characters.
+ * @param len The length of the string, in characters.
+ * @param dest The buffer to write to.
+ * @return The amount of chars narrowed, or SIZE_MAX if one was outside of Latin-1.
+ */
+size_t narrow_sse2(const uint8_t* src, size_t len, uint8_t* dest) {
+    const auto mask = _mm_set1_epi16(NON_LATIN1_MASK);
+    const auto zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + SSE2_CHARS <= len; i += SSE2_CHARS) {
+        const auto* chars = &src[i * sizeof(uint16_t)];
+        auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars));
+        auto high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&chars[sizeof(__m128i)]));
+
+        auto high_bytes = _mm_and_si128(_mm_or_si128(low, high), mask);
+        if ((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(high_bytes, zero)) != ALL_LANES_SET) {
+            return SIZE_MAX;
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), _mm_packus_epi16(low, high));
+    }
+    return i;
+}
+
+/**
+ * @brief Widens the start of a string, 16 chars at a time.
+ *
+ * @param src The Latin-1 characters.
+ * @param len The length of the string, in characters.
+ * @param dest The buffer to write to.
+ * @return The amount of chars widened.
+ */
+size_t widen_sse2(const uint8_t* src, size_t len, wchar_t* dest) {
+    const auto zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + SSE2_CHARS <= len; i += SSE2_CHARS) {
+        auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
+        auto* out = reinterpret_cast<__m128i*>(&dest[i]);
+        _mm_storeu_si128(out, _mm_unpacklo_epi8(chars, zero));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(chars, zero));
+    }
+    return i;
+}
+
+/**
+ * @brief Narrows the start of a string, 32 chars at a time.
+ *
+ * @param src Pointer to the string's characters.
+ * @param len The length of the string, in characters.
+ * @param dest The buffer to write to.
+ * @return The amount of chars narrowed, or SIZE_MAX if one was outside of Latin-1.
+ */
+TARGET_AVX2 size_t narrow_avx2(const uint8_t* src, size_t len, uint8_t* dest) {
+    const auto mask = _mm256_set1_epi16(NON_LATIN1_MASK);
+
+    size_t i = 0;
+    for (; i + AVX2_CHARS <= len; i += AVX2_CHARS) {
+        const auto* chars = &src[i * sizeof(uint16_t)];
+        auto low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chars));
+        auto high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&chars[sizeof(__m256i)]));
+
+        if (_mm256_testz_si256(_mm256_or_si256(low, high), mask) == 0) {
+            return SIZE_MAX;
+        }
+
+        auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), PACK_FIXUP_ORDER);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i]), packed);
+    }
+    return i;
+}
+
+/**
+ * @brief Widens the start of a string, 32 chars at a time.
+ *
+ * @param src The Latin-1 characters.
+ * @param len The length of the string, in characters.
+ * @param dest The buffer to write to.
+ * @return The amount of chars widened.
+ */
+TARGET_AVX2 size_t widen_avx2(const uint8_t* src, size_t len, wchar_t* dest) {
+    size_t i = 0;
+    for (; i + AVX2_CHARS <= len; i += AVX2_CHARS) {
+        auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
+        auto high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i + sizeof(__m128i)]));
+        auto* out = reinterpret_cast<__m256i*>(&dest[i]);
+        _mm256_storeu_si256(out, _mm256_cvtepu8_epi16(low));
+        _mm256_storeu_si256(out + 1, _mm256_cvtepu8_epi16(high));
+    }
+    return i;
+}
+
+}  // namespace
+
+bool narrow(const void* src, size_t len, uint8_t* dest) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(src);
+
+    size_t done = 0;
+    if constexpr (SIMD_SUPPORTED) {
+        done = use_avx2 ? narrow_avx2(bytes, len, dest) : narrow_sse2(bytes, len, dest);
+        if (done == SIZE_MAX) {
+            return false;
+        }
+    }
+    return narrow_scalar(&bytes[done * sizeof(wchar_t)], len - done, &dest[done]);
+}
+
+void widen(const uint8_t* src, size_t len, wchar_t* dest) {
+    size_t done = 0;
+    if constexpr (SIMD_SUPPORTED) {
+        done = use_avx2 ? widen_avx2(src, len, dest) : widen_sse2(src, len, dest);
+    }
+    widen_scalar(&src[done], len - done, &dest[done]);
+}
+
+}  // namespace dhf::hfdat::latin1
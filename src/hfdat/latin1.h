@@ -0,0 +1,32 @@
+#ifndef HFDAT_LATIN1_H
+#define HFDAT_LATIN1_H
+
+#include "pch.h"
+
+namespace dhf::hfdat::latin1 {
+
+/**
+ * @brief Narrows a wide string to Latin-1, one byte per character.
+ * @note Stops early if it finds a character outside of Latin-1, leaving the destination partially
+ *       written.
+ *
+ * @param src Pointer to the string's characters. Needn't be aligned.
+ * @param len The length of the string, in characters.
+ * @param dest The buffer to write to, at least `len` bytes long.
+ * @return True if the whole string fit in Latin-1.
+ */
+[[nodiscard]] bool narrow(const void* src, size_t len, uint8_t* dest);
+
+/**
+ * @brief Widens a Latin-1 string back to wide characters.
+ * @note Doesn't write a null terminator.
+ *
+ * @param src The Latin-1 characters.
+ * @param len The length of the string, in characters.
+ * @param dest The buffer to write to, at least `len` characters long.
+ */
+void widen(const uint8_t* src, size_t len, wchar_t* dest);
+
+}  // namespace dhf::hfdat::latin1
+
+#endif /* HFDAT_LATIN1_H */
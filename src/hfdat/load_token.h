@@ -0,0 +1,69 @@
+#ifndef HFDAT_LOAD_TOKEN_H
+#define HFDAT_LOAD_TOKEN_H
+
+#include "pch.h"
+
+namespace dhf::hfdat {
+
+/**
+ * @brief Exception thrown when a load gets cancelled part way through.
+ */
+class LoadCancelled : public std::exception {
+   public:
+    [[nodiscard]] const char* what(void) const noexcept override { return "Load was cancelled"; }
+};
+
+/**
+ * @brief Token passed down through a load, used to report progress and check for cancellation.
+ * @note A default constructed token never gets cancelled, and discards all progress.
+ */
+class LoadToken {
+   public:
+    LoadToken(void) = default;
+
+    /**
+     * @brief Creates a new token.
+     *
+     * @param stop The stop token used to cancel the load.
+     * @param progress Pointer to the atomic to write progress to.
+     */
+    LoadToken(std::stop_token stop, std::atomic<float>* progress)
+        : stop(std::move(stop)), progress(progress) {}
+
+    /**
+     * @brief Reports progress, and checks if the load has been cancelled.
+     * @note Throws a `LoadCancelled` exception if the load has been cancelled.
+     *
+     * @param fraction How far through the load we are, between 0 and 1.
+     */
+    void update(float fraction) const {
+        if (this->stop.stop_requested()) {
+            throw LoadCancelled{};
+        }
+        if (this->progress != nullptr) {
+            this->progress->store(std::clamp(fraction, 0.0F, 1.0F), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Reports progress in terms of how many items out of a total have been processed.
+     * @note Throws a `LoadCancelled` exception if the load has been cancelled.
+     *
+     * @param done The amount of items processed so far.
+     * @param total The total amount of items.
+     * @param start The progress fraction to report when nothing has been processed.
+     * @param end The progress fraction to report when everything has been processed.
+     */
+    void update(uint64_t done, uint64_t total, float start = 0.0F, float end = 1.0F) const {
+        auto fraction = total == 0 ? 1.0F : (float)((double)done / (double)total);
+        this->update(start + ((end - start) * fraction));
+    }
+
+   private:
+    std::stop_token stop;
+    std::atomic<float>* progress = nullptr;
+};
+
+}  // namespace dhf::hfdat
+
+#endif /* HFDAT_LOAD_TOKEN_H */
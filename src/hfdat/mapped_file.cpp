@@ -0,0 +1,56 @@
+#include "pch.h"
+
+#include "hfdat/mapped_file.h"
+
+namespace dhf::hfdat {
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    // Allow deleting the file while it's mapped, so that nothing gets blocked by loaded sets
+    this->file = CreateFileW(path.wstring().c_str(), GENERIC_READ,
+                             FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (this->file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open file: " + std::to_string(GetLastError()));
+    }
+
+    LARGE_INTEGER file_size{};
+    if (GetFileSizeEx(this->file, &file_size) == FALSE) {
+        this->close();
+        throw std::runtime_error("Failed to get file size: " + std::to_string(GetLastError()));
+    }
+    this->size = (size_t)file_size.QuadPart;
+
+    this->mapping = CreateFileMappingW(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (this->mapping == nullptr) {
+        this->close();
+        throw std::runtime_error("Failed to map file: " + std::to_string(GetLastError()));
+    }
+
+    this->data =
+        reinterpret_cast<const uint8_t*>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+    if (this->data == nullptr) {
+        this->close();
+        throw std::runtime_error("Failed to map view of file: " + std::to_string(GetLastError()));
+    }
+}
+
+MappedFile::~MappedFile() {
+    this->close();
+}
+
+void MappedFile::close(void) {
+    if (this->data != nullptr) {
+        UnmapViewOfFile(this->data);
+        this->data = nullptr;
+    }
+    if (this->mapping != nullptr) {
+        CloseHandle(this->mapping);
+        this->mapping = nullptr;
+    }
+    if (this->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(this->file);
+        this->file = INVALID_HANDLE_VALUE;
+    }
+}
+
+}  // namespace dhf::hfdat
@@ -0,0 +1,43 @@
+#ifndef HFDAT_MAPPED_FILE_H
+#define HFDAT_MAPPED_FILE_H
+
+#include "pch.h"
+
+namespace dhf::hfdat {
+
+/**
+ * @brief RAII wrapper around a read only view of a mapped file.
+ * @note The file may still be deleted or replaced while it's mapped.
+ */
+class MappedFile {
+   public:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    /**
+     * @brief Maps a file into memory.
+     * @note Throws a runtime error on failure.
+     *
+     * @param path The path to the file.
+     */
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+   private:
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+
+    /**
+     * @brief Unmaps and closes everything which has been opened so far.
+     */
+    void close(void);
+};
+
+}  // namespace dhf::hfdat
+
+#endif /* HFDAT_MAPPED_FILE_H */
@@ -0,0 +1,462 @@
+#include "pch.h"
+
+#include "archive.h"
+#include "archive_entry.h"
+#include "hfdat/decode.h"
+#include "hfdat/gzip_index.h"
+#include "hfdat/hfdat.h"
+#include "hfdat/load_token.h"
+#include "hfdat/mapped_file.h"
+#include "hfdat/tar.h"
+
+namespace dhf::hfdat::tar {
+
+namespace {
+
+const constexpr auto ARCHIVE_BLOCK_SIZE = 0x4000;
+// Compressed archives get read from start to end, so if we can't map them, at least read them in
+// large blocks
+const constexpr auto COMPRESSED_ARCHIVE_BLOCK_SIZE = 0x400000;
+const constexpr size_t READ_CHUNK_SIZE = 0x40000;
+
+// How much of a load's progress is taken up by scanning for the right entry
+const constexpr auto SCAN_PROGRESS_END = 0.5F;
+
+// Offsets into a ustar header block
+const constexpr size_t TAR_BLOCK_SIZE = 512;
+const constexpr size_t TAR_NAME_SIZE = 100;
+const constexpr size_t TAR_SIZE_OFFSET = 124;
+const constexpr size_t TAR_SIZE_SIZE = 12;
+const constexpr size_t TAR_MAGIC_OFFSET = 257;
+const constexpr std::string_view TAR_MAGIC = "ustar";
+
+const constexpr auto TOC_NAME = ".toc";
+const constexpr uint32_t TOC_MAGIC = 0x54464844;  // "DHFT"
+const constexpr uint32_t TOC_VERSION = 1;
+// Name length, offsets, size and hotfix count - an entry with an empty name
+const constexpr size_t MIN_TOC_ENTRY_SIZE =
+    sizeof(uint32_t) + (3 * sizeof(uint64_t)) + sizeof(uint32_t);
+
+/**
+ * @brief Struct holding the info the table of contents stores about each hotfix file.
+ */
+struct TocEntry {
+    uint64_t header_offset;
+    uint64_t data_offset;
+    uint64_t size;
+    uint32_t num_hotfixes;
+};
+
+std::filesystem::path hfdat_path;
+bool is_compressed = false;
+bool use_gzip_index = false;
+
+std::vector<std::string> hotfix_names;
+std::vector<TocEntry> toc_entries;
+std::vector<SetInfo> set_info;
+
+/**
+ * @brief Opens an archive at the given path.
+ *
+ * @param path The path to the archive.
+ * @return A pointer to the archive.
+ */
+std::shared_ptr<archive> open_archive(const std::filesystem::path& path) {
+    // Compressed archives have to be decompressed from the very start, so we read them from a
+    // mapped view, and leave paging them in to the os, rather than making a syscall per block.
+    // Uncompressed archives are better off being read normally, since then libarchive can seek past
+    // all the entries we don't need, without touching them at all.
+    std::shared_ptr<MappedFile> mapped;
+    if (is_compressed) {
+        try {
+            mapped = std::make_shared<MappedFile>(path);
+        } catch (const std::exception& ex) {
+            std::cerr << "[dhf] Failed to map archive, falling back to reading it: " << ex.what()
+                      << "\n";
+        }
+    }
+
+    // The deleter holds onto the mapping, so it stays valid for as long as the archive's open
+    auto deleter = [mapped](void* data) { archive_free(reinterpret_cast<archive*>(data)); };
+    std::shared_ptr<archive> ptr{archive_read_new(), deleter};
+
+    archive_read_support_filter_all(ptr.get());
+    archive_read_support_format_all(ptr.get());
+
+    int ret{};
+    if (mapped != nullptr) {
+        ret = archive_read_open_memory(ptr.get(), mapped->data, mapped->size);
+    } else {
+        ret = archive_read_open_filename(
+            ptr.get(), path.generic_string().c_str(),
+            is_compressed ? COMPRESSED_ARCHIVE_BLOCK_SIZE : ARCHIVE_BLOCK_SIZE);
+    }
+    if (ret != ARCHIVE_OK) {
+        throw std::runtime_error("Failed to open archive: " + std::to_string(ret));
+    }
+
+    return ptr;
+}
+
+/**
+ * @brief Reads the entirety of the current archive entry into an existing buffer.
+ *
+ * @param archive The archive to read from.
+ * @param data The buffer to read into.
+ * @param size The size of the entry.
+ * @param on_chunk Callback run after each chunk, with the amount of bytes filled so far.
+ */
+void read_entry_into(const std::shared_ptr<archive>& archive,
+                     uint8_t* data,
+                     size_t size,
+                     const std::function<void(size_t)>& on_chunk) {
+    size_t filled = 0;
+    while (filled < size) {
+        auto ret = archive_read_data(archive.get(), &data[filled],
+                                     std::min(size - filled, READ_CHUNK_SIZE));
+        if (ret <= 0) {
+            throw std::runtime_error("Fail to read from archive: " + std::to_string(ret));
+        }
+        filled += (size_t)ret;
+
+        on_chunk(filled);
+    }
+}
+
+/**
+ * @brief Reads the entirety of the current archive entry into a buffer.
+ *
+ * @param archive The archive to read from.
+ * @param size The size of the entry.
+ * @param token The token to report progress and check for cancellation with.
+ * @return The entry's data.
+ */
+std::vector<uint8_t> read_entry(const std::shared_ptr<archive>& archive,
+                                size_t size,
+                                const LoadToken& token = {}) {
+    std::vector<uint8_t> data(size);
+    read_entry_into(archive, data.data(), size, [&](size_t filled) {
+        token.update(filled, size, SCAN_PROGRESS_END, PARSE_PROGRESS_START);
+    });
+    return data;
+}
+
+/**
+ * @brief Reads the table of contents out of the current archive entry.
+ * @note Leaves the hotfix names, toc entries + set info in an undefined state on error.
+ *
+ * @param archive The archive to read from.
+ * @param size The size of the table of contents entry.
+ */
+void read_toc(const std::shared_ptr<archive>& archive, size_t size) {
+    auto toc = read_entry(archive, size);
+
+    size_t pos = 0;
+    auto read = [&]<typename T>(T* value, size_t len = sizeof(T)) {
+        if (pos + len > toc.size()) {
+            throw std::runtime_error("Table of contents is truncated");
+        }
+        memcpy(value, &toc[pos], len);
+        pos += len;
+    };
+
+    uint32_t magic{};
+    uint32_t version{};
+    uint32_t num_entries{};
+    read(&magic);
+    read(&version);
+    read(&num_entries);
+    if (magic != TOC_MAGIC || version != TOC_VERSION) {
+        throw std::runtime_error("Unknown table of contents version " + std::to_string(version));
+    }
+    // Check the counts against what's left before trusting them with any allocations
+    if (num_entries > (toc.size() - pos) / MIN_TOC_ENTRY_SIZE) {
+        throw std::runtime_error("Table of contents is truncated");
+    }
+
+    hotfix_names.reserve(num_entries);
+    toc_entries.reserve(num_entries);
+    set_info.reserve(num_entries);
+
+    for (uint32_t i = 0; i < num_entries; i++) {
+        uint32_t name_len{};
+        read(&name_len);
+        if (name_len > toc.size() - pos) {
+            throw std::runtime_error("Table of contents is truncated");
+        }
+        auto& name = hotfix_names.emplace_back(name_len, '\0');
+        read(name.data(), name_len);
+
+        auto& entry = toc_entries.emplace_back();
+        read(&entry.header_offset);
+        read(&entry.data_offset);
+        read(&entry.size);
+        read(&entry.num_hotfixes);
+
+        set_info.emplace_back().num_hotfixes = entry.num_hotfixes;
+    }
+
+    // The catalog's optional, so failing to parse it shouldn't stop us using the rest of the toc
+    try {
+        parse_catalog(toc.data() + pos, toc.size() - pos, set_info);
+    } catch (const std::exception& ex) {
+        std::cerr << "[dhf] Failed to read table of contents catalog, ignoring it: " << ex.what()
+                  << "\n";
+    }
+}
+
+/**
+ * @brief Loads a set of hotfixes using the gzip seek point index.
+ *
+ * @param idx The index of the hotfixes to load.
+ * @param hotfixes The set to load the hotfixes into.
+ * @param token The token to report progress and check for cancellation with.
+ */
+void load_from_gzip_index(size_t idx, HotfixSet& hotfixes, const LoadToken& token) {
+    const auto& members = gzip_index::init(hfdat_path, token);
+
+    const auto& name = hotfix_names.at(idx);
+    auto member = std::ranges::find(members, name, &gzip_index::Member::name);
+    if (member == members.end()) {
+        throw std::runtime_error("Couldn't find hotfixes in archive index");
+    }
+
+    auto data = gzip_index::extract(member->data_offset, member->size, token);
+    parse_hotfixes(data.data(), data.size(), hotfixes, token);
+}
+
+/**
+ * @brief Checks that a toc entry lines up with the tar header at the offsets it gives.
+ * @note Throws a runtime error if it doesn't.
+ *
+ * @param file The archive file.
+ * @param file_size The size of the archive file.
+ * @param name The name of the entry.
+ * @param entry The toc entry.
+ */
+void check_toc_entry(std::ifstream& file,
+                     uint64_t file_size,
+                     const std::string& name,
+                     const TocEntry& entry) {
+    // Any extended headers come first, but the member's own header always directly precedes it's
+    //  data
+    if (entry.data_offset < TAR_BLOCK_SIZE
+        || entry.header_offset > entry.data_offset - TAR_BLOCK_SIZE
+        || entry.data_offset > file_size || entry.size > file_size - entry.data_offset) {
+        throw std::runtime_error("Table of contents points outside of the archive");
+    }
+
+    std::array<char, TAR_BLOCK_SIZE> header{};
+    file.seekg((std::streamoff)(entry.data_offset - TAR_BLOCK_SIZE));
+    file.read(header.data(), header.size());
+    if (!file) {
+        throw std::runtime_error("Failed to read tar header");
+    }
+
+    if (std::string_view{&header[TAR_MAGIC_OFFSET], TAR_MAGIC.size()} != TAR_MAGIC) {
+        throw std::runtime_error("Table of contents doesn't point at a tar header");
+    }
+
+    uint64_t size{};
+    const auto* size_start = &header[TAR_SIZE_OFFSET];
+    // Sizes are stored in octal
+    // NOLINTNEXTLINE(readability-magic-numbers)
+    auto result = std::from_chars(size_start, size_start + TAR_SIZE_SIZE, size, 8);
+    if (result.ec != std::errc{} || size != entry.size) {
+        throw std::runtime_error("Table of contents entry size doesn't match tar header");
+    }
+
+    // Longer names only fit in an extended header, don't bother parsing those
+    if (name.size() < TAR_NAME_SIZE
+        && std::string_view{header.data(), strnlen(header.data(), TAR_NAME_SIZE)} != name) {
+        throw std::runtime_error("Table of contents entry name doesn't match tar header");
+    }
+}
+
+/**
+ * @brief Loads a set of hotfixes out of an uncompressed archive, by seeking straight to the
+ *        offsets given in the table of contents.
+ *
+ * @param idx The index of the hotfixes to load.
+ * @param hotfixes The set to load the hotfixes into.
+ * @param token The token to report progress and check for cancellation with.
+ */
+void load_from_toc(size_t idx, HotfixSet& hotfixes, const LoadToken& token) {
+    const auto& entry = toc_entries.at(idx);
+
+    std::ifstream file{hfdat_path, std::ios::binary | std::ios::ate};
+    auto file_size = (uint64_t)file.tellg();
+    check_toc_entry(file, file_size, hotfix_names.at(idx), entry);
+
+    auto read_into = [&](uint8_t* data, size_t size, const std::function<void(size_t)>& on_chunk) {
+        file.seekg((std::streamoff)entry.data_offset);
+        for (size_t filled = 0; filled < size;) {
+            auto chunk = std::min(size - filled, READ_CHUNK_SIZE);
+            file.read(reinterpret_cast<char*>(&data[filled]), (std::streamsize)chunk);
+            if (!file) {
+                throw std::runtime_error("Failed to read from archive");
+            }
+            filled += chunk;
+
+            on_chunk(filled);
+        }
+    };
+
+    auto size = (size_t)entry.size;
+    if (size >= PIPELINE_MIN_SIZE) {
+        pipeline_hotfixes(
+            size,
+            [&](PipelineBuffer& buffer) {
+                read_into(buffer.data(), buffer.size(),
+                          [&](size_t filled) { buffer.publish(filled); });
+            },
+            hotfixes, token, SCAN_PROGRESS_END);
+    } else {
+        std::vector<uint8_t> data(size);
+        read_into(data.data(), size, [&](size_t filled) {
+            token.update(filled, size, SCAN_PROGRESS_END, PARSE_PROGRESS_START);
+        });
+        parse_hotfixes(data.data(), data.size(), hotfixes, token);
+    }
+}
+
+}  // namespace
+
+std::vector<std::string> init(const std::filesystem::path& path) {
+    hfdat_path = path;
+    hotfix_names.clear();
+    toc_entries.clear();
+    set_info.clear();
+    is_compressed = gzip_index::is_gzip(hfdat_path);
+    use_gzip_index = is_compressed;
+
+    auto archive = open_archive(hfdat_path);
+
+    // Newer archives start with a table of contents, which saves us from having to decompress the
+    // entire thing just to get the names
+    archive_entry* entry{};
+    if (archive_read_next_header(archive.get(), &entry) != ARCHIVE_OK) {
+        return hotfix_names;
+    }
+    if (strcmp(archive_entry_pathname_utf8(entry), TOC_NAME) == 0) {
+        try {
+            read_toc(archive, (size_t)archive_entry_size(entry));
+            return hotfix_names;
+        } catch (const std::exception& ex) {
+            std::cerr << "[dhf] Failed to read table of contents, falling back to a full scan: "
+                      << ex.what() << "\n";
+        }
+
+        hotfix_names.clear();
+        toc_entries.clear();
+        set_info.clear();
+    }
+
+    // Without a toc we need to scan the whole archive anyway, so may as well build the index
+    if (use_gzip_index) {
+        try {
+            for (const auto& member : gzip_index::init(hfdat_path)) {
+                hotfix_names.push_back(member.name);
+            }
+            return hotfix_names;
+        } catch (const std::exception& ex) {
+            std::cerr << "[dhf] Failed to index archive, falling back to a full scan: "
+                      << ex.what() << "\n";
+            use_gzip_index = false;
+        }
+        hotfix_names.clear();
+    }
+
+    archive = open_archive(hfdat_path);
+    while (archive_read_next_header(archive.get(), &entry) == ARCHIVE_OK) {
+        auto name = archive_entry_pathname_utf8(entry);
+        if (strcmp(name, TOC_NAME) != 0) {
+            hotfix_names.emplace_back(name);
+        }
+    }
+
+    return hotfix_names;
+}
+
+const std::vector<SetInfo>& get_set_info(void) {
+    return set_info;
+}
+
+void load(size_t idx, HotfixSet& hotfixes, const LoadToken& token) {
+    if (use_gzip_index) {
+        try {
+            load_from_gzip_index(idx, hotfixes, token);
+            if (!toc_entries.empty() && toc_entries.at(idx).num_hotfixes != hotfixes.size()) {
+                throw std::runtime_error("Hotfix count doesn't match table of contents");
+            }
+            return;
+        } catch (const LoadCancelled&) {
+            throw;
+        } catch (const std::exception& ex) {
+            std::cerr << "[dhf] Failed to load hotfixes using archive index, falling back to a "
+                         "full scan: "
+                      << ex.what() << "\n";
+            hotfixes = {};
+            use_gzip_index = false;
+        }
+    }
+
+    // Uncompressed archives can skip straight to the right entry
+    if (!is_compressed && !toc_entries.empty()) {
+        try {
+            load_from_toc(idx, hotfixes, token);
+            if (toc_entries[idx].num_hotfixes != hotfixes.size()) {
+                throw std::runtime_error("Hotfix count doesn't match table of contents");
+            }
+            return;
+        } catch (const LoadCancelled&) {
+            throw;
+        } catch (const std::exception& ex) {
+            std::cerr << "[dhf] Failed to load hotfixes using table of contents, falling back to a "
+                         "full scan: "
+                      << ex.what() << "\n";
+            hotfixes = {};
+        }
+    }
+
+    const auto& name = hotfix_names.at(idx);
+
+    auto archive = open_archive(hfdat_path);
+
+    // Entries should be in the same order as the names, so use that as a progress estimate
+    bool found = false;
+    size_t entries_scanned = 0;
+    archive_entry* entry{};
+    while (archive_read_next_header(archive.get(), &entry) == ARCHIVE_OK) {
+        token.update(entries_scanned++, idx + 1, 0.0F, SCAN_PROGRESS_END);
+        if (name == archive_entry_pathname_utf8(entry)) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        throw std::runtime_error("Couldn't find hotfixes in archive");
+    }
+
+    auto size = (size_t)archive_entry_size(entry);
+    if (size >= PIPELINE_MIN_SIZE) {
+        // Only the worker thread touches the archive until the pipeline's done with it
+        pipeline_hotfixes(
+            size,
+            [&](PipelineBuffer& buffer) {
+                read_entry_into(archive, buffer.data(), buffer.size(),
+                                [&](size_t filled) { buffer.publish(filled); });
+            },
+            hotfixes, token, SCAN_PROGRESS_END);
+    } else {
+        // Read the whole entry in one go, rather than making multiple calls per hotfix
+        auto data = read_entry(archive, size, token);
+        parse_hotfixes(data.data(), data.size(), hotfixes, token);
+    }
+
+    if (!toc_entries.empty() && toc_entries[idx].num_hotfixes != hotfixes.size()) {
+        throw std::runtime_error("Hotfix count doesn't match table of contents");
+    }
+}
+
+}  // namespace dhf::hfdat::tar
@@ -0,0 +1,38 @@
+#ifndef HFDAT_TAR_H
+#define HFDAT_TAR_H
+
+#include "pch.h"
+
+#include "hfdat/hfdat.h"
+#include "hfdat/load_token.h"
+
+namespace dhf::hfdat::tar {
+
+/**
+ * @brief Reads the hotfix names out of a `.tar.gz` hfdat file.
+ *
+ * @param path The path to the hfdat file.
+ * @return A list of all the hotfix names in the file.
+ */
+[[nodiscard]] std::vector<std::string> init(const std::filesystem::path& path);
+
+/**
+ * @brief Gets the metadata of each set in the currently loaded file.
+ *
+ * @return The info of each set, in the same order as the names.
+ */
+[[nodiscard]] const std::vector<SetInfo>& get_set_info(void);
+
+/**
+ * @brief Loads a set of hotfixes out of the `.tar.gz` hfdat file.
+ * @note Throws a runtime error on failure, or a `LoadCancelled` if cancelled.
+ *
+ * @param idx The index of the hotfixes to load, in the list returned by `init`.
+ * @param hotfixes The set to load the hotfixes into.
+ * @param token The token to report progress and check for cancellation with.
+ */
+void load(size_t idx, HotfixSet& hotfixes, const LoadToken& token = {});
+
+}  // namespace dhf::hfdat::tar
+
+#endif /* HFDAT_TAR_H */
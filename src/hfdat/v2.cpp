@@ -0,0 +1,536 @@
+#include "pch.h"
+
+#include "hfdat/decode.h"
+#include "hfdat/hfdat.h"
+#include "hfdat/load_token.h"
+#include "hfdat/v2.h"
+
+namespace dhf::hfdat::v2 {
+
+namespace {
+
+const constexpr uint32_t MAGIC = 0x32464844;  // "DHF2"
+const constexpr uint32_t VERSION = 2;
+const constexpr uint32_t POOLED_VERSION = 3;
+const constexpr uint32_t TIMELINE_VERSION = 4;
+const constexpr uint32_t COLUMNAR_VERSION = 5;
+
+// Base index used by keyframes in timeline files
+const constexpr uint32_t NO_BASE = std::numeric_limits<uint32_t>::max();
+
+// How much to decompress between progress updates
+const constexpr size_t DECOMPRESS_CHUNK_SIZE = 0x40000;
+// How much of the file to read at once while searching for an older footer
+const constexpr size_t FOOTER_SEARCH_CHUNK_SIZE = 0x10000;
+
+/**
+ * @brief The codecs each set may be compressed with.
+ */
+enum class Codec : uint8_t {
+    NONE = 0,
+    ZLIB = 1,
+    ZSTD = 2,
+};
+
+// Name length, offset, sizes, hotfix count and codec - an entry with an empty name
+const constexpr size_t MIN_INDEX_ENTRY_SIZE =
+    sizeof(uint32_t) + (3 * sizeof(uint64_t)) + sizeof(uint32_t) + sizeof(Codec);
+
+/**
+ * @brief Struct holding the info the index stores about each set of hotfixes.
+ */
+struct IndexEntry {
+    uint64_t offset;
+    uint64_t compressed_size;
+    uint64_t decoded_size;
+    // For the string pool, this is the amount of strings instead
+    uint32_t num_hotfixes;
+    Codec codec;
+    // In timeline files, the index of the set this one is a delta against
+    uint32_t base = NO_BASE;
+};
+
+/**
+ * @brief The footer at the very end of the file, pointing at the index.
+ */
+#pragma pack(push, 1)
+struct Footer {
+    uint64_t index_offset;
+    uint32_t index_size;
+    uint32_t magic;
+};
+#pragma pack(pop)
+
+std::filesystem::path hfdat_path;
+
+std::vector<std::string> hotfix_names;
+std::vector<IndexEntry> index_entries;
+std::vector<SetInfo> set_info;
+
+// Pooled files store every unique string once, which all sets refer to by index
+bool pooled = false;
+// Timeline files are pooled, but store most sets as a delta against the set before them
+bool timeline = false;
+// Columnar files store each set on it's own, like the base version, but split into columns
+bool columnar = false;
+IndexEntry pool_entry{};
+// Only kept alive by the sets using it, so it gets freed once none of them are loaded
+std::weak_ptr<const StringPool> string_pool;
+
+/**
+ * @brief Reads a block of data from the file.
+ * @note Throws a runtime error if the full block couldn't be read.
+ *
+ * @param file The file to read from.
+ * @param offset The offset to start reading at.
+ * @param data Pointer to the buffer to read into.
+ * @param size The amount of bytes to read.
+ */
+void read_from_file(std::ifstream& file, uint64_t offset, void* data, size_t size) {
+    file.seekg((std::streamoff)offset);
+    file.read(reinterpret_cast<char*>(data), (std::streamsize)size);
+    if (!file) {
+        throw std::runtime_error("Failed to read from hfdat file");
+    }
+}
+
+/**
+ * @brief Checks if a footer is valid.
+ *
+ * @param footer The footer to check.
+ * @param footer_offset The offset the footer was read from.
+ * @param min_offset The lowest offset the index may start at.
+ * @return True if the footer is valid, and it's index ends directly before it.
+ */
+bool is_valid_footer(const Footer& footer, uint64_t footer_offset, uint64_t min_offset) {
+    return footer.magic == MAGIC && footer.index_offset >= min_offset
+           && footer.index_offset <= footer_offset
+           && footer_offset - footer.index_offset == footer.index_size;
+}
+
+/**
+ * @brief Finds the last complete footer in the file.
+ * @note Appends write the new sets, then the new index, and only then the new footer, so if one
+ *       gets interrupted, the footer from before it is still intact, and points at a full index.
+ *
+ * @param file The file to search.
+ * @param file_size The size of the file.
+ * @param min_offset The lowest offset the index may start at.
+ * @return The footer.
+ */
+Footer find_footer(std::ifstream& file, uint64_t file_size, uint64_t min_offset) {
+    Footer footer{};
+    auto footer_offset = file_size - sizeof(footer);
+    read_from_file(file, footer_offset, &footer, sizeof(footer));
+    if (is_valid_footer(footer, footer_offset, min_offset)) {
+        return footer;
+    }
+
+    // Search backwards, overlapping each chunk with the last so we don't miss any footers which
+    //  cross the boundary between them
+    std::vector<uint8_t> chunk(FOOTER_SEARCH_CHUNK_SIZE + sizeof(footer));
+    auto chunk_end = file_size;
+    while (chunk_end - min_offset >= sizeof(footer)) {
+        auto chunk_start = std::max(min_offset, chunk_end - (uint64_t)chunk.size());
+        read_from_file(file, chunk_start, chunk.data(), (size_t)(chunk_end - chunk_start));
+
+        for (auto pos = (size_t)(chunk_end - chunk_start - sizeof(footer)) + 1; pos-- > 0;) {
+            memcpy(&footer, &chunk[pos], sizeof(footer));
+            if (is_valid_footer(footer, chunk_start + pos, min_offset)) {
+                std::cerr << "[dhf] hfdat file ends in an incomplete append, ignoring the last "
+                          << (file_size - (chunk_start + pos + sizeof(footer))) << " bytes\n";
+                return footer;
+            }
+        }
+
+        chunk_end = chunk_start + sizeof(footer) - 1;
+    }
+
+    throw std::runtime_error("hfdat file has an invalid footer");
+}
+
+/**
+ * @brief Inflates a zlib compressed block of data into a buffer.
+ *
+ * @param compressed The compressed data.
+ * @param decoded The buffer to decompress into.
+ * @param decoded_size The expected size of the data after decompressing.
+ * @param on_chunk Callback run after each chunk, with the amount of bytes filled so far.
+ */
+void inflate_into(std::vector<uint8_t>& compressed,
+                  uint8_t* decoded,
+                  uint64_t decoded_size,
+                  const std::function<void(uint64_t)>& on_chunk) {
+    if (compressed.size() > std::numeric_limits<uInt>::max()) {
+        throw std::runtime_error("Set is too large to decompress");
+    }
+
+    InflateStream stream{MAX_WBITS};
+    stream.strm.next_in = compressed.data();
+    stream.strm.avail_in = (uInt)compressed.size();
+
+    uint64_t filled = 0;
+    int ret{};
+    do {
+        stream.strm.next_out = &decoded[filled];
+        stream.strm.avail_out =
+            (uInt)std::min<uint64_t>(decoded_size - filled, DECOMPRESS_CHUNK_SIZE);
+        auto available = stream.strm.avail_out;
+
+        ret = stream.inflate(Z_NO_FLUSH);
+        if (ret == Z_BUF_ERROR) {
+            throw std::runtime_error("Set is larger than expected");
+        }
+
+        filled += available - stream.strm.avail_out;
+        on_chunk(filled);
+    } while (ret != Z_STREAM_END);
+
+    if (filled != decoded_size) {
+        throw std::runtime_error("Set is smaller than expected");
+    }
+}
+
+/**
+ * @brief Decompresses a zstd compressed block of data into a buffer.
+ *
+ * @param compressed The compressed data.
+ * @param decoded The buffer to decompress into.
+ * @param decoded_size The expected size of the data after decompressing.
+ * @param on_chunk Callback run after each chunk, with the amount of bytes filled so far.
+ */
+void zstd_decompress_into(std::vector<uint8_t>& compressed,
+                          uint8_t* decoded,
+                          uint64_t decoded_size,
+                          const std::function<void(uint64_t)>& on_chunk) {
+    const std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> ctx{ZSTD_createDCtx(),
+                                                                   &ZSTD_freeDCtx};
+    if (ctx == nullptr) {
+        throw std::runtime_error("Failed to initalize zstd");
+    }
+
+    ZSTD_inBuffer input{compressed.data(), compressed.size(), 0};
+
+    uint64_t filled = 0;
+    size_t ret{};
+    do {
+        auto consumed = input.pos;
+        ZSTD_outBuffer output{&decoded[filled],
+                              (size_t)std::min<uint64_t>(decoded_size - filled,
+                                                         DECOMPRESS_CHUNK_SIZE),
+                              0};
+        ret = ZSTD_decompressStream(ctx.get(), &output, &input);
+        if (ZSTD_isError(ret) != 0) {
+            throw std::runtime_error(std::string{"Failed to decompress: "}
+                                     + ZSTD_getErrorName(ret));
+        }
+
+        // If we couldn't make any progress, either we're out of space, or out of data
+        if (output.pos == 0 && input.pos == consumed) {
+            throw std::runtime_error(filled == decoded_size ? "Set is larger than expected"
+                                                            : "Set is truncated");
+        }
+
+        filled += output.pos;
+        on_chunk(filled);
+    } while (ret != 0);
+
+    if (filled != decoded_size) {
+        throw std::runtime_error("Set is smaller than expected");
+    }
+}
+
+/**
+ * @brief Decompresses a block of data into a buffer.
+ * @note Does not support uncompressed blocks, which don't need to go through a buffer.
+ *
+ * @param codec The codec the data was compressed with.
+ * @param compressed The compressed data.
+ * @param decoded The buffer to decompress into.
+ * @param decoded_size The expected size of the data after decompressing.
+ * @param on_chunk Callback run after each chunk, with the amount of bytes filled so far.
+ */
+void decompress_into(Codec codec,
+                     std::vector<uint8_t>& compressed,
+                     uint8_t* decoded,
+                     uint64_t decoded_size,
+                     const std::function<void(uint64_t)>& on_chunk) {
+    switch (codec) {
+        case Codec::ZLIB:
+            inflate_into(compressed, decoded, decoded_size, on_chunk);
+            break;
+        case Codec::ZSTD:
+            zstd_decompress_into(compressed, decoded, decoded_size, on_chunk);
+            break;
+        case Codec::NONE:
+        default:
+            throw std::runtime_error("Unknown codec " + std::to_string((uint32_t)codec));
+    }
+}
+
+/**
+ * @brief Decompresses a block of data.
+ *
+ * @param codec The codec the data was compressed with.
+ * @param compressed The compressed data.
+ * @param decoded_size The expected size of the data after decompressing.
+ * @param token The token to report progress and check for cancellation with.
+ * @return The decompressed data.
+ */
+std::vector<uint8_t> decompress(Codec codec,
+                                std::vector<uint8_t>&& compressed,
+                                uint64_t decoded_size,
+                                const LoadToken& token) {
+    switch (codec) {
+        case Codec::NONE:
+            if (compressed.size() != decoded_size) {
+                throw std::runtime_error("Uncompressed set has the wrong size");
+            }
+            return std::move(compressed);
+
+        default: {
+            std::vector<uint8_t> decoded(decoded_size);
+            decompress_into(codec, compressed, decoded.data(), decoded_size, [&](uint64_t filled) {
+                token.update(filled, decoded_size, 0.0F, PARSE_PROGRESS_START);
+            });
+            return decoded;
+        }
+    }
+}
+
+/**
+ * @brief Reads and decompresses a block out of the file.
+ *
+ * @param file The file to read from.
+ * @param entry The index entry of the block to read.
+ * @param token The token to report progress and check for cancellation with.
+ * @return The decompressed block.
+ */
+std::vector<uint8_t> read_block(std::ifstream& file,
+                                const IndexEntry& entry,
+                                const LoadToken& token) {
+    std::vector<uint8_t> compressed(entry.compressed_size);
+    read_from_file(file, entry.offset, compressed.data(), compressed.size());
+    return decompress(entry.codec, std::move(compressed), entry.decoded_size, token);
+}
+
+/**
+ * @brief Gets the shared string pool, loading it if it's not already.
+ *
+ * @param file The file to read from.
+ * @param token The token to report progress and check for cancellation with.
+ * @return The string pool.
+ */
+std::shared_ptr<const StringPool> get_string_pool(std::ifstream& file, const LoadToken& token) {
+    auto pool = string_pool.lock();
+    if (pool != nullptr) {
+        return pool;
+    }
+
+    auto decoded = read_block(file, pool_entry, token);
+
+    auto new_pool = std::make_shared<StringPool>();
+    parse_string_pool(decoded.data(), decoded.size(), *new_pool, token);
+    if (new_pool->size() != pool_entry.num_hotfixes) {
+        throw std::runtime_error("String count doesn't match index");
+    }
+
+    std::cout << std::format("[dhf] Loaded string pool of {} strings ({} KiB)\n", new_pool->size(),
+                             // NOLINTNEXTLINE(readability-magic-numbers)
+                             new_pool->memory_usage() / 1024);
+
+    string_pool = new_pool;
+    return new_pool;
+}
+
+/**
+ * @brief Rebuilds the pool indexes of a set in a timeline file.
+ * @note Walks back to the closest keyframe, then applies each delta after it in turn, so the amount
+ *       of work is bounded by the keyframe interval the file was written with.
+ *
+ * @param file The file to read from.
+ * @param idx The index of the set to rebuild.
+ * @param token The token to report progress and check for cancellation with.
+ * @return The pool indexes of the set.
+ */
+std::vector<uint32_t> rebuild_from_timeline(std::ifstream& file,
+                                            size_t idx,
+                                            const LoadToken& token) {
+    // Bases are always validated to come earlier in the file, so this always terminates
+    std::vector<size_t> chain{idx};
+    while (index_entries[chain.back()].base != NO_BASE) {
+        chain.push_back(index_entries[chain.back()].base);
+    }
+
+    std::vector<uint32_t> ids;
+    for (size_t i = chain.size(); i-- > 0;) {
+        const auto& entry = index_entries[chain[i]];
+        auto step = chain.size() - 1 - i;
+
+        // Report progress per block, rather than letting each decompress report it's own
+        auto decoded = read_block(file, entry, {});
+        token.update(step + 1, chain.size(), 0.0F, PARSE_PROGRESS_START);
+
+        ids = entry.base == NO_BASE ? parse_pooled_ids(decoded.data(), decoded.size())
+                                    : apply_delta(decoded.data(), decoded.size(), ids);
+        if (ids.size() != (size_t)entry.num_hotfixes * 2) {
+            throw std::runtime_error("Hotfix count doesn't match index");
+        }
+    }
+
+    return ids;
+}
+
+}  // namespace
+
+bool is_v2(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    uint32_t magic{};
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    return file && magic == MAGIC;
+}
+
+std::vector<std::string> init(const std::filesystem::path& path) {
+    hfdat_path = path;
+    hotfix_names.clear();
+    index_entries.clear();
+    set_info.clear();
+    string_pool.reset();
+
+    std::ifstream file{hfdat_path, std::ios::binary | std::ios::ate};
+    auto file_size = (uint64_t)file.tellg();
+
+    uint32_t header[2]{};
+    read_from_file(file, 0, &header[0], sizeof(header));
+    if (header[0] != MAGIC
+        || (header[1] != VERSION && header[1] != POOLED_VERSION && header[1] != TIMELINE_VERSION
+            && header[1] != COLUMNAR_VERSION)) {
+        throw std::runtime_error("Unknown hfdat version " + std::to_string(header[1]));
+    }
+    pooled = header[1] == POOLED_VERSION || header[1] == TIMELINE_VERSION;
+    timeline = header[1] == TIMELINE_VERSION;
+    columnar = header[1] == COLUMNAR_VERSION;
+
+    if (file_size < sizeof(header) + sizeof(Footer)) {
+        throw std::runtime_error("hfdat file is truncated");
+    }
+    auto footer = find_footer(file, file_size, sizeof(header));
+
+    std::vector<uint8_t> index(footer.index_size);
+    read_from_file(file, footer.index_offset, index.data(), index.size());
+
+    size_t pos = 0;
+    auto read = [&]<typename T>(T* value, size_t len = sizeof(T)) {
+        if (pos + len > index.size()) {
+            throw std::runtime_error("hfdat index is truncated");
+        }
+        memcpy(value, &index[pos], len);
+        pos += len;
+    };
+
+    auto read_entry = [&](IndexEntry& entry) {
+        read(&entry.offset);
+        read(&entry.compressed_size);
+        read(&entry.decoded_size);
+        read(&entry.num_hotfixes);
+        read(&entry.codec);
+
+        // Written to avoid overflowing on garbage sizes
+        if (entry.offset > footer.index_offset
+            || entry.compressed_size > footer.index_offset - entry.offset) {
+            throw std::runtime_error("hfdat index points outside of the file");
+        }
+    };
+
+    if (pooled) {
+        read_entry(pool_entry);
+    }
+
+    uint32_t num_sets{};
+    read(&num_sets);
+    // Check the counts against what's left before trusting them with any allocations
+    if (num_sets > (index.size() - pos) / MIN_INDEX_ENTRY_SIZE) {
+        throw std::runtime_error("hfdat index is truncated");
+    }
+
+    hotfix_names.reserve(num_sets);
+    index_entries.reserve(num_sets);
+
+    for (uint32_t i = 0; i < num_sets; i++) {
+        uint32_t name_len{};
+        read(&name_len);
+        if (name_len > index.size() - pos) {
+            throw std::runtime_error("hfdat index is truncated");
+        }
+        auto& name = hotfix_names.emplace_back(name_len, '\0');
+        read(name.data(), name_len);
+
+        auto& entry = index_entries.emplace_back();
+        read_entry(entry);
+
+        if (timeline) {
+            read(&entry.base);
+            if (entry.base != NO_BASE && entry.base >= i) {
+                throw std::runtime_error("hfdat index has a delta against a later set");
+            }
+        }
+
+        auto& info = set_info.emplace_back();
+        info.num_hotfixes = entry.num_hotfixes;
+        info.stored_size = entry.compressed_size;
+    }
+
+    // The catalog's optional, so failing to parse it shouldn't stop the sets from loading
+    try {
+        parse_catalog(index.data() + pos, index.size() - pos, set_info);
+    } catch (const std::exception& ex) {
+        std::cerr << "[dhf] Failed to read hfdat catalog, ignoring it: " << ex.what() << "\n";
+    }
+
+    return hotfix_names;
+}
+
+const std::vector<SetInfo>& get_set_info(void) {
+    return set_info;
+}
+
+bool uses_string_pool(void) {
+    return pooled;
+}
+
+void load(size_t idx, HotfixSet& hotfixes, const LoadToken& token) {
+    const auto& entry = index_entries.at(idx);
+
+    std::ifstream file{hfdat_path, std::ios::binary};
+    if (timeline) {
+        auto ids = rebuild_from_timeline(file, idx, token);
+        build_pooled_hotfixes(ids, get_string_pool(file, token), hotfixes, token);
+    } else if (pooled) {
+        auto decoded = read_block(file, entry, token);
+        auto ids = parse_pooled_ids(decoded.data(), decoded.size());
+        build_pooled_hotfixes(ids, get_string_pool(file, token), hotfixes, token);
+    } else if (columnar) {
+        // Every column needs to be available from the very first hotfix, so there's no point
+        //  pipelining these
+        auto decoded = read_block(file, entry, token);
+        parse_columnar_hotfixes(decoded.data(), decoded.size(), hotfixes, token);
+    } else if (entry.codec != Codec::NONE && entry.decoded_size >= PIPELINE_MIN_SIZE) {
+        std::vector<uint8_t> compressed(entry.compressed_size);
+        read_from_file(file, entry.offset, compressed.data(), compressed.size());
+        pipeline_hotfixes(
+            entry.decoded_size,
+            [&](PipelineBuffer& buffer) {
+                decompress_into(entry.codec, compressed, buffer.data(), buffer.size(),
+                                [&](uint64_t filled) { buffer.publish(filled); });
+            },
+            hotfixes, token);
+    } else {
+        auto decoded = read_block(file, entry, token);
+        parse_hotfixes(decoded.data(), decoded.size(), hotfixes, token);
+    }
+    if (hotfixes.size() != entry.num_hotfixes) {
+        throw std::runtime_error("Hotfix count doesn't match index");
+    }
+}
+
+}  // namespace dhf::hfdat::v2
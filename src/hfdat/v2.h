@@ -0,0 +1,53 @@
+#ifndef HFDAT_V2_H
+#define HFDAT_V2_H
+
+#include "pch.h"
+
+#include "hfdat/hfdat.h"
+#include "hfdat/load_token.h"
+
+namespace dhf::hfdat::v2 {
+
+/**
+ * @brief Checks if the given hfdat file uses the v2 format.
+ *
+ * @param path The path to the hfdat file.
+ * @return True if the file is a v2 hfdat.
+ */
+[[nodiscard]] bool is_v2(const std::filesystem::path& path);
+
+/**
+ * @brief Reads the hotfix names out of a v2 hfdat file.
+ *
+ * @param path The path to the hfdat file.
+ * @return A list of all the hotfix names in the file.
+ */
+[[nodiscard]] std::vector<std::string> init(const std::filesystem::path& path);
+
+/**
+ * @brief Gets the metadata of each set in the currently loaded file.
+ *
+ * @return The info of each set, in the same order as the names.
+ */
+[[nodiscard]] const std::vector<SetInfo>& get_set_info(void);
+
+/**
+ * @brief Checks if the currently loaded file stores it's sets as indexes into a shared string pool.
+ *
+ * @return True if the file is pooled, or a timeline.
+ */
+[[nodiscard]] bool uses_string_pool(void);
+
+/**
+ * @brief Loads a set of hotfixes out of the v2 hfdat file.
+ * @note Throws a runtime error on failure, or a `LoadCancelled` if cancelled.
+ *
+ * @param idx The index of the hotfixes to load, in the list returned by `init`.
+ * @param hotfixes The set to load the hotfixes into.
+ * @param token The token to report progress and check for cancellation with.
+ */
+void load(size_t idx, HotfixSet& hotfixes, const LoadToken& token = {});
+
+}  // namespace dhf::hfdat::v2
+
+#endif /* HFDAT_V2_H */
@@ -1,5 +1,6 @@
 #include "pch.h"
 
+#include "hotfixes/hooks.h"
 #include "hotfixes/processing.h"
 #include "hotfixes/unreal.h"
 #include "memory.h"
@@ -21,14 +22,36 @@ const Pattern MALLOC_PATTERN{
 using malloc_func = void* (*)(size_t, uint32_t);
 malloc_func malloc_ptr;
 
+using realloc_func = void* (*)(void*, size_t, uint32_t);
+realloc_func realloc_ptr;
+
+using free_func = void (*)(void*);
+free_func free_ptr;
+
+const Allocator UNREAL_ALLOCATOR{
+    [](size_t len) { return malloc_ptr(len, MALLOC_ALIGNMENT); },
+    [](void* original, size_t len) { return realloc_ptr(original, len, MALLOC_ALIGNMENT); },
+    [](void* data) { free_ptr(data); },
+};
+
+const Allocator STAND_IN_ALLOCATOR{
+    [](size_t len) { return std::malloc(len); },
+    [](void* original, size_t len) { return std::realloc(original, len); },
+    [](void* data) { std::free(data); },
+};
+
+Allocator allocator = UNREAL_ALLOCATOR;
+
 }  // namespace
 
-void* u_malloc(size_t count) {
-    auto ret = malloc_ptr(count, MALLOC_ALIGNMENT);
+void* u_malloc(size_t count, bool zero) {
+    auto ret = allocator.allocate(count);
     if (ret == nullptr) {
         throw std::runtime_error("Failed to allocate memory!");
     }
-    memset(ret, 0, count);
+    if (zero) {
+        memset(ret, 0, count);
+    }
     return ret;
 }
 
@@ -40,13 +63,10 @@ const Pattern REALLOC_PATTERN{
     "\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
     "\xFF\x00\x00\x00\x00\xFF\xFF\xFF"};
 
-using realloc_func = void* (*)(void*, size_t, uint32_t);
-realloc_func realloc_ptr;
-
 }  // namespace
 
 void* u_realloc(void* original, size_t count) {
-    auto ret = realloc_ptr(original, count, MALLOC_ALIGNMENT);
+    auto ret = allocator.reallocate(original, count);
     if (ret == nullptr) {
         throw std::runtime_error("Failed to re-allocate memory!");
     }
@@ -59,13 +79,18 @@ const Pattern FREE_PATTERN{
     "\x48\x85\xC9\x74\x00\x53\x48\x83\xEC\x20\x48\x8B\xD9\x48\x8B\x0D\x00\x00\x00\x00",
     "\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00"};
 
-using free_func = void (*)(void*);
-free_func free_ptr;
-
 }  // namespace
 
 void u_free(void* data) {
-    free_ptr(data);
+    allocator.deallocate(data);
+}
+
+const Allocator& get_stand_in_allocator(void) {
+    return STAND_IN_ALLOCATOR;
+}
+
+void set_allocator(const Allocator& new_allocator) {
+    allocator = new_allocator;
 }
 
 namespace {
@@ -8,17 +8,45 @@ namespace dhf::hotfixes {
  */
 void init(void);
 
+/**
+ * @brief The functions used to allocate any memory which gets handed over to unreal.
+ */
+struct Allocator {
+    void* (*allocate)(size_t len);
+    void* (*reallocate)(void* original, size_t len);
+    void (*deallocate)(void* data);
+};
+
+/**
+ * @brief Gets an allocator backed by the c runtime, which can stand in for unreal's.
+ * @note Only for use outside of the game - unreal can't free memory from it.
+ *
+ * @return The stand-in allocator.
+ */
+[[nodiscard]] const Allocator& get_stand_in_allocator(void);
+
+/**
+ * @brief Replaces the allocator used by `u_malloc`, `u_realloc`, and `u_free`.
+ * @note Defaults to unreal's allocator, which is only available after calling `init`.
+ *
+ * @param allocator The new allocator.
+ */
+void set_allocator(const Allocator& allocator);
+
 /**
  * @brief Calls unreal's malloc function.
+ * @note Zeros the memory by default. Callers which are about to overwrite all of it anyway, such
+ *       as when copying in a string, can skip this.
  *
  * @tparam T The type to cast the return to.
  * @param len The amount of bytes to allocate.
+ * @param zero True if to zero the allocated memory.
  * @return A pointer to the allocated memory.
  */
-[[nodiscard]] void* u_malloc(size_t len);
+[[nodiscard]] void* u_malloc(size_t len, bool zero = true);
 template <typename T>
-[[nodiscard]] T* u_malloc(size_t len) {
-    return reinterpret_cast<T*>(u_malloc(len));
+[[nodiscard]] T* u_malloc(size_t len, bool zero = true) {
+    return reinterpret_cast<T*>(u_malloc(len, zero));
 }
 
 /**
@@ -0,0 +1,99 @@
+#include "pch.h"
+
+#include "hfdat/hotfix_set.h"
+#include "hotfixes/hooks.h"
+#include "hotfixes/json.h"
+#include "hotfixes/unreal.h"
+
+namespace dhf::hotfixes {
+
+VFTables vf_table = {};
+
+void alloc_string(FString* str, std::wstring_view value) {
+    str->count = (uint32_t)value.size() + 1;
+    str->max = str->count;
+    // No point zeroing it, we're about to overwrite every char
+    str->data = u_malloc<wchar_t>(str->count * sizeof(wchar_t), false);
+    memcpy(str->data, value.data(), value.size() * sizeof(wchar_t));
+    str->data[value.size()] = L'\0';
+}
+
+void alloc_string(FString* str, const hfdat::PooledString& value) {
+    str->count = (uint32_t)value.size() + 1;
+    str->max = str->count;
+    // No point zeroing it, we're about to overwrite every char
+    str->data = u_malloc<wchar_t>(str->count * sizeof(wchar_t), false);
+    value.copy_to(str->data);
+}
+
+void build_object_hash(FJsonObject* obj) {
+    auto num_entries = obj->entries.count;
+
+    auto& flags = obj->allocation_flags;
+    auto num_words = (num_entries + TBitArray::BITS_PER_WORD - 1) / TBitArray::BITS_PER_WORD;
+    if (num_words > TBitArray::NUM_INLINE_WORDS) {
+        flags.data.secondary_data = u_malloc<uint32_t>(num_words * sizeof(uint32_t));
+    } else {
+        num_words = TBitArray::NUM_INLINE_WORDS;
+    }
+    flags.num_bits = (int32_t)num_entries;
+    flags.max_bits = (int32_t)(num_words * TBitArray::BITS_PER_WORD);
+    for (uint32_t i = 0; i < num_entries; i++) {
+        flags.data.get()[i / TBitArray::BITS_PER_WORD] |= 1U << (i % TBitArray::BITS_PER_WORD);
+    }
+
+    // Nothing's ever been removed, so the free list is empty
+    obj->first_free_idx = -1;
+    obj->num_free_indices = 0;
+
+    // A single bucket fits inline
+    obj->hash_size = 1;
+    if (num_entries >= MIN_HASHED_ELEMENTS) {
+        obj->hash_size =
+            (int32_t)std::bit_ceil(num_entries / AVG_ELEMENTS_PER_BUCKET + BASE_HASH_BUCKETS);
+        obj->hash.secondary_data = u_malloc<int32_t>(obj->hash_size * sizeof(int32_t), false);
+    }
+    auto buckets = obj->hash.get();
+    std::fill_n(buckets, obj->hash_size, -1);
+
+    // Each entry gets added to the start of it's bucket, so chains run from the last entry added
+    for (uint32_t i = 0; i < num_entries; i++) {
+        auto& entry = obj->entries.data[i];
+        entry.hash_idx =
+            (int32_t)(strihash({entry.key.data, entry.key.count - 1}) & (obj->hash_size - 1));
+        entry.hash_next_id = buckets[entry.hash_idx];
+        buckets[entry.hash_idx] = (int32_t)i;
+    }
+}
+
+FJsonValueObject* create_json_value_object(FJsonObject* obj) {
+    auto val_obj = u_malloc<FJsonValueObject>(sizeof(FJsonValueObject));
+    val_obj->vf_table = vf_table.json_value_object;
+    val_obj->type = EJson::OBJECT;
+
+    val_obj->value.obj = obj;
+    add_ref_controller(&val_obj->value, vf_table.shared_ptr_json_object);
+
+    return val_obj;
+}
+
+void free_param_entry(const TSharedPtr<FJsonValue>& entry) {
+    auto val_obj = reinterpret_cast<FJsonValueObject*>(entry.obj);
+    auto obj = val_obj->to_obj();
+    for (uint32_t j = 0; j < obj->entries.count; j++) {
+        auto str = reinterpret_cast<FJsonValueString*>(obj->entries.data[j].value.obj);
+        u_free(str->str.data);
+        u_free(str);
+        u_free(obj->entries.data[j].value.ref_controller);
+        u_free(obj->entries.data[j].key.data);
+    }
+    u_free(obj->entries.data);
+    u_free(obj->allocation_flags.data.secondary_data);
+    u_free(obj->hash.secondary_data);
+    u_free(obj);
+    u_free(val_obj->value.ref_controller);
+    u_free(val_obj);
+    u_free(entry.ref_controller);
+}
+
+}  // namespace dhf::hotfixes
@@ -0,0 +1,178 @@
+#ifndef HOTFIXES_JSON_H
+#define HOTFIXES_JSON_H
+
+#include "pch.h"
+
+#include "hfdat/hotfix_set.h"
+#include "hotfixes/hooks.h"
+#include "hotfixes/unreal.h"
+
+namespace dhf::hotfixes {
+
+/**
+ * @brief Struct holding all the vf tables we need to grab copies of.
+ */
+struct VFTables {
+    // Atomic since the gui thread checks it before starting to prepare parameters
+    std::atomic<bool> found;
+    void* json_value_string;
+    void* json_value_array;
+    void* json_value_object;
+    void* shared_ptr_json_object;
+    void* shared_ptr_json_value;
+};
+
+/// The vf tables every json object we create uses, copied from the game's own objects.
+extern VFTables vf_table;
+
+// These mirror `FDefaultSetAllocator`, which decides how many hash buckets a map's set gets
+const constexpr uint32_t MIN_HASHED_ELEMENTS = 4;
+const constexpr uint32_t AVG_ELEMENTS_PER_BUCKET = 2;
+const constexpr uint32_t BASE_HASH_BUCKETS = 8;
+
+/**
+ * @brief Adds a reference controller to a shared pointer.
+ * @note The object must already be set before calling this.
+ *
+ * @tparam T The type of the shared pointer.
+ * @param ptr The shared pointer to edit.
+ * @param vf_table The vf table for the shared pointer's type.
+ */
+template <typename T>
+void add_ref_controller(TSharedPtr<T>* ptr, void* vf_table) {
+    ptr->ref_controller = u_malloc<FReferenceControllerBase>(sizeof(FReferenceControllerBase));
+    ptr->ref_controller->vf_table = vf_table;
+    ptr->ref_controller->ref_count = 1;
+    ptr->ref_controller->weak_ref_count = 1;
+    ptr->ref_controller->obj = ptr->obj;
+}
+
+/**
+ * @brief Allocated memory to set an FString to a given value.
+ * @note Also sets the string count.
+ *
+ * @param str The FString to fill.
+ * @param value The value to set.
+ */
+void alloc_string(FString* str, std::wstring_view value);
+
+/**
+ * @brief Allocated memory to set an FString to a string out of a hotfix set.
+ * @note Also sets the string count.
+ * @note This is where Latin-1 strings get widened back out.
+ *
+ * @param str The FString to fill.
+ * @param value The value to set.
+ */
+void alloc_string(FString* str, const hfdat::PooledString& value);
+
+/**
+ * @brief Creates a json string object.
+ *
+ * @tparam T The type of the value, either a wide string view, or a string out of a hotfix set.
+ * @param value The value of the string.
+ * @return A pointer to the new object.
+ */
+template <typename T>
+FJsonValueString* create_json_string(const T& value) {
+    auto obj = u_malloc<FJsonValueString>(sizeof(FJsonValueString));
+    obj->vf_table = vf_table.json_value_string;
+    obj->type = EJson::STRING;
+    alloc_string(&obj->str, value);
+
+    return obj;
+}
+
+/**
+ * @brief Fills in a json object's allocation flags and hash to match it's entries, the same way
+ *        Unreal would, so that the game can look up keys in it as normal.
+ * @note Assumes the object was zero-initialized, and that all it's keys have been set.
+ * @note Objects with under `MIN_HASHED_ELEMENTS` entries only get a single bucket, so are known to
+ *       match. Larger objects are bucketed using `strihash`, which hasn't been checked against an
+ *       object built by the game yet.
+ *
+ * @param obj The object to fill in.
+ */
+void build_object_hash(FJsonObject* obj);
+
+/**
+ * @brief Creates a json object.
+ * @note Limited to objects which fit in a single hash bucket, see `build_object_hash`.
+ *
+ * @tparam n The amount of entries in the object.
+ * @param entries Key-value pairs of the object's entries.
+ * @return A pointer to the new object.
+ */
+template <size_t n>
+FJsonObject* create_json_object(
+    const std::array<std::pair<std::wstring_view, FJsonValue*>, n>& entries) {
+    static_assert(0 < n);
+    // Until `strihash` has been checked against the buckets of a game-built object, don't risk
+    //  handing the game any objects which rely on it
+    static_assert(n < MIN_HASHED_ELEMENTS);
+
+    auto obj = u_malloc<FJsonObject>(sizeof(FJsonObject));
+
+    obj->entries.count = n;
+    obj->entries.max = n;
+    obj->entries.data = u_malloc<JSONObjectEntry>(n * sizeof(JSONObjectEntry));
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+    for (size_t i = 0; i < n; i++) {
+        alloc_string(&obj->entries.data[i].key, entries[i].first);
+
+        obj->entries.data[i].value.obj = entries[i].second;
+        add_ref_controller(&obj->entries.data[i].value, vf_table.shared_ptr_json_value);
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+
+    build_object_hash(obj);
+
+    return obj;
+}
+
+/**
+ * @brief Create a json array object.
+ *
+ * @param entries The entries in the array.
+ * @return A pointer to the new object
+ */
+template <uint8_t n>
+FJsonValueArray* create_json_array(const std::array<FJsonValue*, n>& entries) {
+    auto obj = u_malloc<FJsonValueArray>(sizeof(FJsonValueArray));
+    obj->vf_table = vf_table.json_value_array;
+    obj->type = EJson::ARRAY;
+
+    obj->entries.count = n;
+    obj->entries.max = n;
+    obj->entries.data = u_malloc<TSharedPtr<FJsonValue>>(n * sizeof(TSharedPtr<FJsonValue>));
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+    for (auto i = 0; i < n; i++) {
+        obj->entries.data[i].obj = entries[i];
+        add_ref_controller(&obj->entries.data[i], vf_table.shared_ptr_json_value);
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+
+    return obj;
+}
+
+/**
+ * @brief Create a json value object from a raw object.
+ *
+ * @param obj The object to create a value object of.
+ * @return A pointer to the new value object.
+ */
+FJsonValueObject* create_json_value_object(FJsonObject* obj);
+
+/**
+ * @brief Frees one of our micropatch parameters, and everything it holds.
+ * @note Ignores the ref counts, the caller must make sure nothing else holds a reference to it.
+ *
+ * @param entry The entry to free.
+ */
+void free_param_entry(const TSharedPtr<FJsonValue>& entry);
+
+}  // namespace dhf::hotfixes
+
+#endif /* HOTFIXES_JSON_H */
@@ -1,7 +1,8 @@
 #include "pch.h"
 
-#include "hfdat.h"
+#include "hfdat/hfdat.h"
 #include "hotfixes/hooks.h"
+#include "hotfixes/json.h"
 #include "hotfixes/processing.h"
 #include "hotfixes/unreal.h"
 #include "settings.h"
@@ -20,45 +21,6 @@ const constexpr uint64_t FNV_PRIME = 0x100000001b3;
 std::string running_hotfix_name_internal = "n/a";
 uint64_t running_hotfix_hash_internal = 0;
 
-/**
- * @brief Struct holding all the vf tables we need to grab copies of.
- */
-struct VFTables {
-    bool found;
-    void* json_value_string;
-    void* json_value_array;
-    void* json_value_object;
-    void* shared_ptr_json_object;
-    void* shared_ptr_json_value;
-} vf_table = {};
-
-// Haven't managed to fully reverse engineer json objects, but their extra data is always constant
-//  for objects with the same amount of entries, so as a hack we can just hardcode it
-
-// clang-format off
-const uint32_t KNOWN_OBJECT_PATTERNS[3][16] = {{
-    // Objects of size 1
-    0x00000001, 0x00000000, 0x00000000, 0x00000000,
-    0x00000000, 0x00000000, 0x00000001, 0x00000080,
-    0xFFFFFFFF, 0x00000000, 0x00000000, 0x00000000,
-    0x00000000, 0x00000000, 0x00000001, 0x00000000,
-}, {
-    // Objects of size 2
-    0x00000003, 0x00000000, 0x00000000, 0x00000000,
-    0x00000000, 0x00000000, 0x00000002, 0x00000080,
-    0xFFFFFFFF, 0x00000000, 0x00000001, 0x00000000,
-    0x00000000, 0x00000000, 0x00000001, 0x00000000,
-}, {
-    // Objects of size 3
-    0x00000007, 0x00000000, 0x00000000, 0x00000000,
-    0x00000000, 0x00000000, 0x00000003, 0x00000080,
-    0xFFFFFFFF, 0x00000000, 0x00000002, 0x00000000,
-    0x00000000, 0x00000000, 0x00000001, 0x00000000,
-}};
-// clang-format on
-
-static_assert(sizeof(KNOWN_OBJECT_PATTERNS[0]) == sizeof(FJsonObject::pattern));
-
 /**
  * @brief Gathers all required vf table pointers and fills in the vf table struct.
  *
@@ -84,125 +46,416 @@ void gather_vf_tables(const FJsonObject* discovery_json) {
 }
 
 /**
- * @brief Adds a reference controller to a shared pointer.
- * @note The object must already be set before calling this.
+ * @brief Gets the raw stored bytes of a string out of a hotfix set.
  *
- * @tparam T The type of the shared pointer.
- * @param ptr The shared pointer to edit.
- * @param vf_table The vf table for the shared pointer's type.
+ * @param str The string.
+ * @return A view of it's bytes.
  */
-template <typename T>
-void add_ref_controller(TSharedPtr<T>* ptr, void* vf_table) {
-    ptr->ref_controller = u_malloc<FReferenceControllerBase>(sizeof(FReferenceControllerBase));
-    ptr->ref_controller->vf_table = vf_table;
-    ptr->ref_controller->ref_count = 1;
-    ptr->ref_controller->weak_ref_count = 1;
-    ptr->ref_controller->obj = ptr->obj;
+std::string_view raw_bytes(const hfdat::PooledString& str) {
+    return {reinterpret_cast<const char*>(str.data()), str.byte_size()};
 }
 
 /**
- * @brief Allocated memory to set an FString to a given value.
- * @note Also sets the string count.
+ * @brief A hotfix's key and value, used to find entries which can be reused between sets.
+ */
+struct HotfixKey {
+    hfdat::PooledString key;
+    hfdat::PooledString value;
+
+    bool operator==(const HotfixKey& other) const {
+        // Strings always get narrowed if they can be, so equal strings are always stored the same
+        return this->key.is_wide() == other.key.is_wide()
+               && this->value.is_wide() == other.value.is_wide()
+               && raw_bytes(this->key) == raw_bytes(other.key)
+               && raw_bytes(this->value) == raw_bytes(other.value);
+    }
+};
+
+struct HotfixKeyHash {
+    size_t operator()(const HotfixKey& hotfix) const {
+        const std::hash<std::string_view> hash{};
+        return (hash(raw_bytes(hotfix.key)) * FNV_PRIME) ^ hash(raw_bytes(hotfix.value));
+    }
+};
+
+/**
+ * @brief Struct holding the entries last handed to the game, so that they can be reused.
+ * @note Holds a reference to each entry, which gets passed on to the next set if it reuses it, or
+ *       otherwise released when the next set is handed over.
+ */
+struct ReusableParams {
+    /// The hotfixes the entries were built from, which own the strings used as map keys.
+    std::shared_ptr<const hfdat::LoadedHotfixes> source;
+    /// One entry per hotfix, in the same order.
+    std::vector<TSharedPtr<FJsonValue>> entries;
+    /// Maps each hotfix to the index of it's entry.
+    std::unordered_map<HotfixKey, size_t, HotfixKeyHash> index;
+};
+
+/**
+ * @brief Struct holding a set of hotfixes already turned into micropatch parameters.
+ */
+struct PreparedParams {
+    /// One value object per hotfix, each holding a key-value object, ready to hand to the game.
+    TArray<TSharedPtr<FJsonValue>> entries;
+    /// How many references to add to each entry reused from the last set when handing it over, or
+    ///  0 for newly created entries.
+    std::vector<uint8_t> reused_refs;
+    /// The entries to keep around for reuse once these have been handed to the game.
+    std::shared_ptr<const ReusableParams> reusable;
+    /// The entries from the last set which aren't being kept, and need their references released.
+    std::vector<TSharedPtr<FJsonValue>> dropped;
+    /// The crc32 of every key and value, see `predict_hotfix_hash`.
+    uint32_t content_hash;
+};
+
+/**
+ * @brief Struct holding the parameters being prepared in the background for the next injection.
+ */
+struct PendingParams {
+    /// The snapshot being prepared, or null if nothing is.
+    std::shared_ptr<const hfdat::LoadedHotfixes> source;
+    /// The prepared parameters, once they're ready. May not be valid even if there's a source.
+    std::future<PreparedParams> params;
+};
+
+// Don't bother splitting up sets into chunks smaller than this
+const constexpr size_t MIN_HOTFIXES_PER_WORKER = 1024;
+
+std::mutex pending_params_mutex;
+PendingParams pending_params;
+// Only replaced by the discovery hook. Since any pending params are always started after the last
+//  replacement, every entry they reuse is guaranteed to still be alive when they're handed over.
+std::shared_ptr<const ReusableParams> reusable_params;
+// Set between taking the prepared params and replacing the reusable params with them. Nothing may
+//  start preparing in that window, since it would reuse entries which are about to be released.
+bool handover_in_progress = false;
+
+/**
+ * @brief Frees a set of prepared parameters which never got handed to the game.
+ * @note Skips any entries which were never filled in, so may be used on a partial build.
+ * @note Leaves reused entries alone, they're still owned by the parameters they came from.
  *
- * @param str The FString to fill.
- * @param value The value to set.
+ * @param prepared The parameters to free.
  */
-void alloc_string(FString* str, const std::wstring& value) {
-    str->count = (uint32_t)value.size() + 1;
-    str->max = str->count;
-    str->data = u_malloc<wchar_t>(str->count * sizeof(wchar_t));
-    wcsncpy_s(str->data, str->count, value.c_str(), str->count - 1);
+void free_prepared_params(const PreparedParams& prepared) {
+    for (uint32_t i = 0; i < prepared.entries.count; i++) {
+        if (prepared.entries.data[i].obj != nullptr && prepared.reused_refs[i] == 0) {
+            free_param_entry(prepared.entries.data[i]);
+        }
+    }
+    u_free(prepared.entries.data);
 }
 
 /**
- * @brief Creates a json string object.
+ * @brief Advances a content hash over a string out of a hotfix set, as it would be in an FString.
  *
- * @param value The value of the string.
- * @return A pointer to the new object.
+ * @param content_hash The hash to advance.
+ * @param str The string to hash.
+ * @param buffer A buffer to use to widen the string.
+ * @return The number of bytes hashed.
  */
-FJsonValueString* create_json_string(const std::wstring& value) {
-    auto obj = u_malloc<FJsonValueString>(sizeof(FJsonValueString));
-    obj->vf_table = vf_table.json_value_string;
-    obj->type = EJson::STRING;
-    alloc_string(&obj->str, value);
-
-    return obj;
+size_t hash_pooled_string(uLong& content_hash,
+                          const hfdat::PooledString& str,
+                          std::vector<wchar_t>& buffer) {
+    buffer.resize(str.size() + 1);
+    str.copy_to(buffer.data());
+    content_hash = crc32_z(content_hash, reinterpret_cast<const Bytef*>(buffer.data()),
+                           buffer.size() * sizeof(wchar_t));
+    return buffer.size() * sizeof(wchar_t);
 }
 
 /**
- * @brief Creates a json object.
+ * @brief Turns part of a set of hotfixes into micropatch parameters.
+ * @note Never touches the reused entries themselves, since the game may be using them at the same
+ *       time, just copies their pointers.
  *
- * @tparam n The amount of entries in the object.
- * @param entries Key-value pairs of the object's entries.
- * @return A pointer to the new object.
+ * @param hotfixes The set of hotfixes.
+ * @param previous The entries which may be reused, or null.
+ * @param start The index of the first hotfix to convert.
+ * @param end The index after the last hotfix to convert.
+ * @param prepared The parameters to write into, at the same indexes as the hotfixes.
+ * @param reused_from Set to the index of the previous entry each reused entry came from.
+ * @param hashed_bytes Set to how many bytes went into the content hash.
+ * @return The crc32 of every key and value in the range.
  */
-template <uint8_t n>
-FJsonObject* create_json_object(
-    const std::array<std::pair<std::wstring, FJsonValue*>, n>& entries) {
-    static_assert(0 < n && n <= ARRAYSIZE(KNOWN_OBJECT_PATTERNS));
+uint32_t build_params_range(const hfdat::HotfixSet& hotfixes,
+                            const ReusableParams* previous,
+                            size_t start,
+                            size_t end,
+                            PreparedParams& prepared,
+                            std::vector<uint32_t>& reused_from,
+                            size_t& hashed_bytes) {
+    auto content_hash = crc32_z(0, nullptr, 0);
+    hashed_bytes = 0;
+
+    std::vector<wchar_t> buffer;
+    for (auto i = start; i < end; i++) {
+        auto [key, value] = hotfixes[i];
+
+        if (previous != nullptr) {
+            auto existing = previous->index.find({key, value});
+            if (existing != previous->index.end()) {
+                prepared.entries.data[i] = previous->entries[existing->second];
+                // One for the array, one for when we keep it around for reuse again
+                prepared.reused_refs[i] = 2;
+                reused_from[i] = (uint32_t)existing->second;
+
+                hashed_bytes += hash_pooled_string(content_hash, key, buffer);
+                hashed_bytes += hash_pooled_string(content_hash, value, buffer);
+                continue;
+            }
+        }
 
-    auto obj = u_malloc<FJsonObject>(sizeof(FJsonObject));
-    memcpy(&obj->pattern[0], &KNOWN_OBJECT_PATTERNS[n - 1][0], sizeof(obj->pattern));
+        auto key_str = create_json_string(key);
+        auto value_str = create_json_string(value);
 
-    obj->entries.count = n;
-    obj->entries.max = n;
-    obj->entries.data = u_malloc<JSONObjectEntry>(n * sizeof(JSONObjectEntry));
+        // Hash as we go, in the same way as for the current hotfixes in the discovery hook
+        for (const auto* str : {&key_str->str, &value_str->str}) {
+            content_hash = crc32_z(content_hash, reinterpret_cast<const Bytef*>(str->data),
+                                   str->count * sizeof(wchar_t));
+            hashed_bytes += str->count * sizeof(wchar_t);
+        }
 
-    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
-    for (auto i = 0; i < n; i++) {
-        obj->entries.data[i].hash_next_id = ((int32_t)i) - 1;
+        auto hotfix_entry = create_json_object<2>({{{L"key", key_str}, {L"value", value_str}}});
 
-        alloc_string(&obj->entries.data[i].key, entries[i].first);
+        prepared.entries.data[i].obj = create_json_value_object(hotfix_entry);
+        add_ref_controller(&prepared.entries.data[i], vf_table.shared_ptr_json_value);
+        // Nothing else can see this yet, so it's safe to add the reference we keep for reuse now
+        prepared.entries.data[i].ref_controller->ref_count++;
+    }
 
-        obj->entries.data[i].value.obj = entries[i].second;
-        add_ref_controller(&obj->entries.data[i].value, vf_table.shared_ptr_json_value);
+    return (uint32_t)content_hash;
+}
+
+/**
+ * @brief Turns a set of hotfixes into micropatch parameters, split across all cores.
+ * @note Reuses whatever entries it can from the previous parameters, only allocating new ones for
+ *       hotfixes which weren't in them.
+ *
+ * @param hotfixes The snapshot of hotfixes.
+ * @param previous The entries which may be reused, or null.
+ * @return The prepared parameters.
+ */
+PreparedParams build_params(const std::shared_ptr<const hfdat::LoadedHotfixes>& hotfixes,
+                            const std::shared_ptr<const ReusableParams>& previous) {
+    auto start = std::chrono::steady_clock::now();
+
+    auto size = (uint32_t)hotfixes->hotfixes.size();
+    PreparedParams prepared{{nullptr, size, size},
+                            std::vector<uint8_t>(size),
+                            {},
+                            {},
+                            (uint32_t)crc32_z(0, nullptr, 0)};
+    std::vector<uint32_t> reused_from(size);
+
+    size_t num_workers = 0;
+    if (size > 0) {
+        // Zeroed, so that we can tell which entries have been filled in if a worker fails
+        prepared.entries.data =
+            u_malloc<TSharedPtr<FJsonValue>>(size * sizeof(TSharedPtr<FJsonValue>));
+
+        num_workers = std::clamp<size_t>(size / MIN_HOTFIXES_PER_WORKER, 1,
+                                         std::max(std::thread::hardware_concurrency(), 1U));
+
+        std::vector<uint32_t> hashes(num_workers);
+        std::vector<size_t> hashed_bytes(num_workers);
+        std::vector<std::exception_ptr> errors(num_workers);
+
+        auto run_worker = [&](size_t worker) {
+            try {
+                hashes[worker] = build_params_range(
+                    hotfixes->hotfixes, previous.get(), size * worker / num_workers,
+                    size * (worker + 1) / num_workers, prepared, reused_from, hashed_bytes[worker]);
+            } catch (...) {
+                errors[worker] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(num_workers - 1);
+        for (size_t worker = 1; worker < num_workers; worker++) {
+            workers.emplace_back(run_worker, worker);
+        }
+        run_worker(0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        for (const auto& error : errors) {
+            if (error != nullptr) {
+                free_prepared_params(prepared);
+                std::rethrow_exception(error);
+            }
+        }
+
+        prepared.content_hash = hashes[0];
+        for (size_t worker = 1; worker < num_workers; worker++) {
+            prepared.content_hash = (uint32_t)crc32_combine(
+                prepared.content_hash, hashes[worker], (z_off_t)hashed_bytes[worker]);
+        }
+    }
+
+    auto reusable = std::make_shared<ReusableParams>();
+    reusable->source = hotfixes;
+    reusable->entries.assign(prepared.entries.data, prepared.entries.data + size);
+    reusable->index.reserve(size);
+    for (uint32_t i = 0; i < size; i++) {
+        reusable->index.try_emplace({hotfixes->hotfixes.key(i), hotfixes->hotfixes.value(i)}, i);
+    }
+    prepared.reusable = std::move(reusable);
+
+    // Rather than adding a reference for the new set to keep, and releasing the one the last set
+    //  kept, just pass it on, so the hook has to touch as few ref counts as possible
+    size_t num_reused = 0;
+    if (previous != nullptr) {
+        std::vector<uint8_t> passed_on(previous->entries.size());
+        for (uint32_t i = 0; i < size; i++) {
+            if (prepared.reused_refs[i] == 0) {
+                continue;
+            }
+            num_reused++;
+            if (passed_on[reused_from[i]] == 0) {
+                passed_on[reused_from[i]] = 1;
+                prepared.reused_refs[i]--;
+            }
+        }
+        for (size_t i = 0; i < previous->entries.size(); i++) {
+            if (passed_on[i] == 0) {
+                prepared.dropped.push_back(previous->entries[i]);
+            }
+        }
     }
-    // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
 
-    return obj;
+    auto duration = std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << std::format("[dhf] Prepared {} hotfixes ({} reused) on {} threads in {:.1f}ms\n",
+                             size, num_reused, num_workers, duration.count());
+
+    return prepared;
 }
 
 /**
- * @brief Create a json array object.
+ * @brief Updates the ref counts of a set of prepared parameters as they get handed to the game, and
+ *        releases the game's own parameters which they're replacing.
+ * @note Unreal's json shared pointers aren't thread safe, so this may only be called from the
+ *       discovery hook, on the same thread the game releases it's own references.
  *
- * @param entries The entries in the array.
- * @return A pointer to the new object
+ * @param prepared The parameters being handed over.
+ * @param replaced The game's original parameters. Takes ownership of the array.
+ */
+void hand_over_params(const PreparedParams& prepared,
+                      const TArray<TSharedPtr<FJsonValue>>& replaced) {
+    for (uint32_t i = 0; i < prepared.entries.count; i++) {
+        if (prepared.reused_refs[i] != 0) {
+            prepared.entries.data[i].ref_controller->ref_count += prepared.reused_refs[i];
+        }
+    }
+
+    std::vector<TSharedPtr<FJsonValue>> unused;
+    for (const auto& entry : prepared.dropped) {
+        if (--entry.ref_controller->ref_count == 0) {
+            unused.push_back(entry);
+        }
+    }
+
+    // The game's original parameters were allocated by the game, and get destroyed through it's own
+    //  vf tables, so release them here, on the same thread the game would have
+    for (uint32_t i = 0; i < replaced.count; i++) {
+        replaced.data[i].reset();
+    }
+
+    std::shared_ptr<const ReusableParams> previous;
+    {
+        const std::lock_guard<std::mutex> lock{pending_params_mutex};
+        previous = std::exchange(reusable_params, prepared.reusable);
+        handover_in_progress = false;
+    }
+
+    // Nothing else references the unused entries anymore, and they're entirely our own memory, so
+    //  they can be freed from any thread, along with the now empty array
+    // Also make sure the previous set's lookup map gets destroyed over there, it's not that quick
+    std::thread{[unused = std::move(unused), replaced_data = replaced.data,
+                 previous = std::move(previous)]() mutable {
+        for (const auto& entry : unused) {
+            free_param_entry(entry);
+        }
+        u_free(replaced_data);
+        previous = nullptr;
+    }}.detach();
+}
+
+/**
+ * @brief Throws away the pending parameters, freeing them in the background once they're ready.
+ * @note Assumes the pending params mutex is held.
  */
-template <uint8_t n>
-FJsonValueArray* create_json_array(const std::array<FJsonValue*, n>& entries) {
-    auto obj = u_malloc<FJsonValueArray>(sizeof(FJsonValueArray));
-    obj->vf_table = vf_table.json_value_array;
-    obj->type = EJson::ARRAY;
-
-    obj->entries.count = n;
-    obj->entries.max = n;
-    obj->entries.data = u_malloc<TSharedPtr<FJsonValue>>(n * sizeof(TSharedPtr<FJsonValue>));
-
-    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
-    for (auto i = 0; i < n; i++) {
-        obj->entries.data[i].obj = entries[i];
-        add_ref_controller(&obj->entries.data[i], vf_table.shared_ptr_json_value);
+void discard_pending_params(void) {
+    pending_params.source = nullptr;
+    if (!pending_params.params.valid()) {
+        return;
     }
-    // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
 
-    return obj;
+    std::thread{[params = std::move(pending_params.params)]() mutable {
+        try {
+            free_prepared_params(params.get());
+        } catch (const std::exception&) {
+            // A failed build has already freed everything it allocated
+        }
+    }}.detach();
 }
 
 /**
- * @brief Create a json value object from a raw object.
+ * @brief Starts preparing parameters for a set of hotfixes in the background.
+ * @note Does nothing if that set's already being prepared, if it uses the current hotfixes, or
+ *       while a handover is in progress.
+ * @note Assumes the pending params mutex is held.
  *
- * @param obj The object to create a value object of.
- * @return A pointer to the new value object.
+ * @param hotfixes The snapshot of hotfixes to prepare.
  */
-FJsonValueObject* create_json_value_object(FJsonObject* obj) {
-    auto val_obj = u_malloc<FJsonValueObject>(sizeof(FJsonValueObject));
-    val_obj->vf_table = vf_table.json_value_object;
-    val_obj->type = EJson::OBJECT;
+void start_preparing_params(std::shared_ptr<const hfdat::LoadedHotfixes> hotfixes) {
+    if (handover_in_progress || pending_params.source == hotfixes) {
+        return;
+    }
+    discard_pending_params();
 
-    val_obj->value.obj = obj;
-    add_ref_controller(&val_obj->value, vf_table.shared_ptr_json_object);
+    pending_params.source = std::move(hotfixes);
+    if (pending_params.source->use_current) {
+        return;
+    }
 
-    return val_obj;
+    // Unlike `std::async`, a packaged task's future doesn't block when it's destroyed
+    std::packaged_task<PreparedParams(void)> task{
+        [hotfixes = pending_params.source, previous = reusable_params]() {
+            return build_params(hotfixes, previous);
+        }};
+    pending_params.params = task.get_future();
+    std::thread{std::move(task)}.detach();
+}
+
+/**
+ * @brief Takes the prepared parameters for a set of hotfixes, to hand them over to the game.
+ * @note Starts preparing them now if they weren't already.
+ * @note Blocks preparing anything else until they're handed over, or the handover is cancelled.
+ *
+ * @param hotfixes The snapshot of hotfixes to get the parameters of.
+ * @return A future holding the prepared parameters. Must be used, or they'll be leaked.
+ */
+std::future<PreparedParams> take_prepared_params(
+    std::shared_ptr<const hfdat::LoadedHotfixes> hotfixes) {
+    const std::lock_guard<std::mutex> lock{pending_params_mutex};
+    start_preparing_params(std::move(hotfixes));
+
+    pending_params.source = nullptr;
+    handover_in_progress = true;
+    return std::move(pending_params.params);
+}
+
+/**
+ * @brief Cancels a handover after the prepared parameters failed to build, since nothing changed.
+ */
+void cancel_handover(void) {
+    const std::lock_guard<std::mutex> lock{pending_params_mutex};
+    handover_in_progress = false;
 }
 
 /**
@@ -216,22 +469,16 @@ std::wstring get_current_time_str(void) {
 }
 
 /**
- * @brief Resets the running hotfix hash.
- */
-void hash_reset(void) {
-    running_hotfix_hash_internal = FNV_BASIS;
-}
-
-/**
- * @brief Advances the running hotfix hash over a range of bytes.
+ * @brief Advances an FNV-1a hash over a range of bytes.
  *
+ * @param hash The hash to advance.
  * @param data The start of the data.
  * @param len The length of data.
  */
-void hash_advance(const uint8_t* data, size_t len) {
+void hash_advance(uint64_t& hash, const uint8_t* data, size_t len) {
     for (size_t i = 0; i < len; i++) {
-        running_hotfix_hash_internal ^= data[i];
-        running_hotfix_hash_internal *= FNV_PRIME;
+        hash ^= data[i];
+        hash *= FNV_PRIME;
     }
 }
 
@@ -240,6 +487,26 @@ void hash_advance(const uint8_t* data, size_t len) {
 const std::string& running_hotfix_name = running_hotfix_name_internal;
 const uint64_t& running_hotfix_hash = running_hotfix_hash_internal;
 
+void prepare_parameters(void) {
+    if (!vf_table.found) {
+        return;
+    }
+
+    const std::lock_guard<std::mutex> lock{pending_params_mutex};
+    start_preparing_params(hfdat::get_loaded_hotfixes());
+}
+
+uint64_t predict_hotfix_hash(uint32_t content_hash) {
+    auto hash = FNV_BASIS;
+
+    // This includes the version number, so will change all the hashes in an update
+    hash_advance(hash, reinterpret_cast<const uint8_t*>(FULL_PROJECT_NAME),
+                 sizeof(FULL_PROJECT_NAME));
+    hash_advance(hash, reinterpret_cast<const uint8_t*>(&content_hash), sizeof(content_hash));
+
+    return hash;
+}
+
 void handle_discovery_from_json(FJsonObject** json) {
     gather_vf_tables(*json);
 
@@ -247,15 +514,21 @@ void handle_discovery_from_json(FJsonObject** json) {
 
     FJsonObject* micropatch = nullptr;
     for (uint32_t i = 0; i < services->count(); i++) {
-        auto service = services->get<FJsonValueObject>(i)->to_obj();
-        if (service->get<FJsonValueString>(L"service_name")->to_wstr() == L"Micropatch") {
-            micropatch = service;
+        auto service = services->find<FJsonValueObject>(i);
+        if (service == nullptr) {
+            continue;
+        }
+        auto name = service->to_obj()->find<FJsonValueString>(L"service_name");
+        if (name != nullptr && name->equals(L"Micropatch")) {
+            micropatch = service->to_obj();
             break;
         }
     }
 
     // This happens during the first verify call so don't throw
     if (micropatch == nullptr) {
+        // We've got the vf tables now though, so can get a head start on the real call
+        prepare_parameters();
         return;
     }
 
@@ -265,38 +538,61 @@ void handle_discovery_from_json(FJsonObject** json) {
 
     auto params = micropatch->get<FJsonValueArray>(L"parameters");
 
-    running_hotfix_name_internal = hfdat::loaded_hotfixes_name;
-    if (!hfdat::use_current_hotfixes) {
-        params->entries.count = (uint32_t)hfdat::hotfixes.size();
-        if (params->entries.count > params->entries.max) {
-            params->entries.max = params->entries.count;
-            params->entries.data = u_realloc<TSharedPtr<FJsonValue>>(
-                params->entries.data, params->entries.max * sizeof(TSharedPtr<FJsonValue>));
-        }
-
-        for (size_t i = 0; i < hfdat::hotfixes.size(); i++) {
-            const auto& [key, value] = hfdat::hotfixes[i];
+    // Grab a snapshot, so the hotfixes stay alive even if the gui loads new ones part way through
+    auto loaded = hfdat::get_loaded_hotfixes();
 
-            auto hotfix_entry = create_json_object<2>(
-                {{{L"key", create_json_string(key)}, {L"value", create_json_string(value)}}});
+    running_hotfix_name_internal = loaded->name;
+    if (!loaded->use_current) {
+        auto start = std::chrono::steady_clock::now();
 
-            params->entries.data[i].obj = create_json_value_object(hotfix_entry);
-            add_ref_controller(&params->entries.data[i], vf_table.shared_ptr_json_value);
+        // Normally these were prepared in the background long before we got here
+        PreparedParams prepared;
+        try {
+            prepared = take_prepared_params(loaded).get();
+        } catch (const std::exception&) {
+            cancel_handover();
+            throw;
         }
+        hand_over_params(prepared, params->entries);
+        params->entries = prepared.entries;
+        running_hotfix_hash_internal = predict_hotfix_hash(prepared.content_hash);
+
+        auto duration = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+            std::chrono::steady_clock::now() - start);
+        std::cout << std::format("[dhf] Injected {} hotfixes in {:.0f}us\n", params->count(),
+                                 duration.count());
+
+        // The game verifies every so often, so get the next copy ready for the next call
+        {
+            const std::lock_guard<std::mutex> lock{pending_params_mutex};
+            start_preparing_params(loaded);
+        }
+        return;
     }
 
-    hash_reset();
-
-    // This includes the version number, so will change all the hashes in an update
-    hash_advance(reinterpret_cast<const uint8_t*>(FULL_PROJECT_NAME), sizeof(FULL_PROJECT_NAME));
-
+    // Hash the hotfixes on their own first, so that the gui can predict the final hash of each set
+    //  from the content hash in the hfdat's catalog
+    // This uses crc32 rather than fnv since zlib's is a lot faster, both here and in archive.py
+    auto content_hash = crc32_z(0, nullptr, 0);
+    uint32_t num_malformed = 0;
     for (uint32_t i = 0; i < params->count(); i++) {
-        auto entry = params->get<FJsonValueObject>(i)->to_obj();
-        auto key = entry->get<FJsonValueString>(L"key")->str;
-        auto value = entry->get<FJsonValueString>(L"value")->str;
+        auto entry = params->find<FJsonValueObject>(i);
+        auto key = entry == nullptr ? nullptr : entry->to_obj()->find<FJsonValueString>(L"key");
+        auto value = entry == nullptr ? nullptr : entry->to_obj()->find<FJsonValueString>(L"value");
+        if (key == nullptr || value == nullptr) {
+            num_malformed++;
+            continue;
+        }
 
-        hash_advance(reinterpret_cast<const uint8_t*>(key.data), key.count * sizeof(wchar_t));
-        hash_advance(reinterpret_cast<const uint8_t*>(value.data), value.count * sizeof(wchar_t));
+        content_hash = crc32_z(content_hash, reinterpret_cast<const Bytef*>(key->str.data),
+                               key->str.count * sizeof(wchar_t));
+        content_hash = crc32_z(content_hash, reinterpret_cast<const Bytef*>(value->str.data),
+                               value->str.count * sizeof(wchar_t));
+    }
+    running_hotfix_hash_internal = predict_hotfix_hash((uint32_t)content_hash);
+
+    if (num_malformed > 0) {
+        std::cerr << "[dhf] Skipped hashing " << num_malformed << " malformed hotfixes\n";
     }
 }
 
@@ -306,6 +602,10 @@ void handle_news_from_json(FJsonObject** json) {
     }
 
     auto news_data = (*json)->get<FJsonValueArray>(L"data");
+    // Only a handful of articles, not worth deferring like the micropatch parameters
+    for (uint32_t i = 0; i < news_data->entries.count; i++) {
+        news_data->entries.data[i].reset();
+    }
     news_data->entries.count = 1;
     if (news_data->entries.count > news_data->entries.max) {
         news_data->entries.max = news_data->entries.count;
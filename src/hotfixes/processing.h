@@ -8,6 +8,22 @@ struct FJsonObject;
 extern const std::string& running_hotfix_name;
 extern const uint64_t& running_hotfix_hash;
 
+/**
+ * @brief Works out what the running hotfix hash will be after the game receives a set of hotfixes.
+ *
+ * @param content_hash The crc32 of every key and value in the set, one after the other, each as
+ *                     utf16 including it's null terminator.
+ * @return The running hotfix hash.
+ */
+[[nodiscard]] uint64_t predict_hotfix_hash(uint32_t content_hash);
+
+/**
+ * @brief Starts turning the loaded hotfixes into unreal json objects in the background, so that
+ *        they're ready to inject by the time the game asks for them.
+ * @note Thread safe. Does nothing until the first discovery call, or if that's already been done.
+ */
+void prepare_parameters(void);
+
 /**
  * @brief Handles `GbxSparkSdk::Discovery::Services::FromJson` calls, inserting our custom hotfixes.
  *
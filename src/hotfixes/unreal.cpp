@@ -32,15 +32,60 @@ struct JTypeMapping<FJsonValueObject> {
 
 template <typename T>
 T* FJsonValue::cast(void) {
-    if (this->type != JTypeMapping<T>::ENUM_TYPE) {
+    auto ret = this->try_cast<T>();
+    if (ret == nullptr) {
         throw std::runtime_error("JSON object was of unexpected type "
                                  + std::to_string((uint32_t)this->type));
     }
+    return ret;
+}
+
+template <typename T>
+T* FJsonValue::try_cast(void) {
+    if (this->type != JTypeMapping<T>::ENUM_TYPE) {
+        return nullptr;
+    }
     return reinterpret_cast<T*>(this);
 }
 
 #pragma endregion
 
+#pragma region Reference Counting
+
+namespace {
+
+// Unreal declares `DestroyObject` before the virtual destructor, so it comes first in the vf table
+using destroy_object_func = void (*)(FReferenceControllerBase* self);
+using deleting_destructor_func = void* (*)(FReferenceControllerBase* self, uint32_t flags);
+
+const constexpr auto DESTROY_OBJECT_VF_IDX = 0;
+const constexpr auto DELETING_DESTRUCTOR_VF_IDX = 1;
+
+// Tells MSVC's deleting destructor to also free the memory after destructing
+const constexpr uint32_t DELETE_FLAG = 1;
+
+}  // namespace
+
+void FReferenceControllerBase::release(void) {
+    if (--this->ref_count > 0) {
+        return;
+    }
+
+    auto vf_table = reinterpret_cast<void**>(this->vf_table);
+    auto destroy_object = reinterpret_cast<destroy_object_func>(vf_table[DESTROY_OBJECT_VF_IDX]);
+    destroy_object(this);
+
+    // The shared references between them hold a single weak reference
+    if (--this->weak_ref_count > 0) {
+        return;
+    }
+    auto deleting_destructor =
+        reinterpret_cast<deleting_destructor_func>(vf_table[DELETING_DESTRUCTOR_VF_IDX]);
+    deleting_destructor(this, DELETE_FLAG);
+}
+
+#pragma endregion
+
 #pragma region Accessors
 
 std::wstring FString::to_wstr(void) const {
@@ -57,21 +102,18 @@ uint32_t FJsonValueArray::count() const {
 
 template <typename T>
 T* FJsonValueArray::get(uint32_t idx) const {
-    if (idx > this->count()) {
+    if (idx >= this->count()) {
         throw std::out_of_range("Array index out of range");
     }
     return this->entries.data[idx].obj->cast<T>();
 }
 
 template <typename T>
-T* FJsonObject::get(const std::wstring& key) const {
-    for (uint32_t i = 0; i < this->entries.count; i++) {
-        auto entry = this->entries.data[i];
-        if (entry.key.to_wstr() == key) {
-            return entry.value.obj->cast<T>();
-        }
+T* FJsonValueArray::find(uint32_t idx) const {
+    if (idx >= this->count()) {
+        return nullptr;
     }
-    throw std::runtime_error("Couldn't find key!");
+    return this->entries.data[idx].obj->try_cast<T>();
 }
 
 FJsonObject* FJsonValueObject::to_obj(void) const {
@@ -86,13 +128,17 @@ template FJsonValueString* FJsonValue::cast(void);
 template FJsonValueArray* FJsonValue::cast(void);
 template FJsonValueObject* FJsonValue::cast(void);
 
+template FJsonValueString* FJsonValue::try_cast(void);
+template FJsonValueArray* FJsonValue::try_cast(void);
+template FJsonValueObject* FJsonValue::try_cast(void);
+
 template FJsonValueString* FJsonValueArray::get(uint32_t) const;
 template FJsonValueArray* FJsonValueArray::get(uint32_t) const;
 template FJsonValueObject* FJsonValueArray::get(uint32_t) const;
 
-template FJsonValueString* FJsonObject::get(const std::wstring& key) const;
-template FJsonValueArray* FJsonObject::get(const std::wstring& key) const;
-template FJsonValueObject* FJsonObject::get(const std::wstring& key) const;
+template FJsonValueString* FJsonValueArray::find(uint32_t) const;
+template FJsonValueArray* FJsonValueArray::find(uint32_t) const;
+template FJsonValueObject* FJsonValueArray::find(uint32_t) const;
 
 #pragma endregion
 
@@ -19,6 +19,23 @@ struct FString : TArray<wchar_t> {
      * @return An stl string.
      */
     [[nodiscard]] std::wstring to_wstr(void) const;
+
+    /**
+     * @brief Checks if this string is equal to a wide string literal, without allocating.
+     *
+     * @tparam n The size of the literal, including it's null terminator.
+     * @param literal The literal to compare against.
+     * @return True if the strings are equal.
+     */
+    template <size_t n>
+    [[nodiscard]] bool equals(const wchar_t (&literal)[n]) const {
+        // Empty strings may not have been allocated at all, otherwise the count includes the null
+        //  terminator, same as the size of the literal
+        if (this->count == 0) {
+            return n == 1;
+        }
+        return this->count == n && memcmp(this->data, &literal[0], (n - 1) * sizeof(wchar_t)) == 0;
+    }
 };
 
 struct FReferenceControllerBase {
@@ -26,12 +43,34 @@ struct FReferenceControllerBase {
     int32_t ref_count;
     int32_t weak_ref_count;
     void* obj;
+
+    /**
+     * @brief Releases a shared reference, destroying the object, and then this controller, if they
+     *        were the last references to them.
+     * @note Goes through the controller's vf table, so the game frees everything using it's own
+     *       destructors, same as if it released the reference itself.
+     * @note Unreal's json shared pointers aren't thread safe, so this may only be called where
+     *       nothing else can touch the same ref counts at the same time.
+     */
+    void release(void);
 };
 
 template <typename T>
 struct TSharedPtr {
     T* obj;
     FReferenceControllerBase* ref_controller;
+
+    /**
+     * @brief Releases this pointer's reference, and clears it.
+     * @note Subject to the same thread safety restrictions as `FReferenceControllerBase::release`.
+     */
+    void reset(void) {
+        if (this->ref_controller != nullptr) {
+            this->ref_controller->release();
+        }
+        this->obj = nullptr;
+        this->ref_controller = nullptr;
+    }
 };
 
 enum class EJson {
@@ -57,36 +96,231 @@ struct FJsonValue {
      */
     template <typename T>
     T* cast(void);
+
+    /**
+     * @brief Tries to cast this object to a specific type.
+     *
+     * @tparam T The type to cast to.
+     * @return A pointer to this object casted to the relevant type, or nullptr if the type doesn't
+     *         line up.
+     */
+    template <typename T>
+    [[nodiscard]] T* try_cast(void);
 };
 
+/**
+ * @brief An allocation stored inline in it's owner, until it grows too large and moves to the heap.
+ *
+ * @tparam T The type of the elements.
+ * @tparam n The number of elements which fit inline.
+ */
+template <typename T, size_t n>
+struct TInlineAllocation {
+    T inline_data[n];
+    T* secondary_data;
+
+    /**
+     * @brief Gets a pointer to the elements, wherever they're currently stored.
+     *
+     * @return A pointer to the first element.
+     */
+    [[nodiscard]] T* get(void) {
+        return this->secondary_data != nullptr ? this->secondary_data : &this->inline_data[0];
+    }
+    [[nodiscard]] const T* get(void) const {
+        return this->secondary_data != nullptr ? this->secondary_data : &this->inline_data[0];
+    }
+};
+
+struct TBitArray {
+    static const constexpr auto NUM_INLINE_WORDS = 4;
+    static const constexpr auto BITS_PER_WORD = 32;
+
+    TInlineAllocation<uint32_t, NUM_INLINE_WORDS> data;
+    int32_t num_bits;
+    int32_t max_bits;
+
+    /**
+     * @brief Checks if a bit is set.
+     * @note Bits past the end of the array count as unset.
+     *
+     * @param idx The index of the bit.
+     * @return True if the bit is set.
+     */
+    [[nodiscard]] bool is_set(uint32_t idx) const {
+        if (this->num_bits < 0 || idx >= (uint32_t)this->num_bits
+            || (this->data.secondary_data == nullptr && idx >= NUM_INLINE_WORDS * BITS_PER_WORD)) {
+            return false;
+        }
+        return (this->data.get()[idx / BITS_PER_WORD] & (1U << (idx % BITS_PER_WORD))) != 0;
+    }
+};
+
+// Unreal's `FCrc::CRCTable_DEPRECATED` - the msb first crc32 table, even though `strihash` indexes
+//  it the reflected way, shifting right
+const constexpr auto STRIHASH_CRC_TABLE = []() {
+    const constexpr uint32_t CRC32_POLY = 0x04C11DB7;
+    const constexpr uint32_t TOP_BIT = 0x80000000;
+    const constexpr auto TOP_BYTE_SHIFT = 24;
+
+    std::array<uint32_t, 256> table{};  // NOLINT(readability-magic-numbers)
+    for (uint32_t i = 0; i < table.size(); i++) {
+        auto crc = i << TOP_BYTE_SHIFT;
+        for (auto bit = 0; bit < 8; bit++) {  // NOLINT(readability-magic-numbers)
+            crc = (crc & TOP_BIT) != 0 ? (crc << 1) ^ CRC32_POLY : crc << 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}();
+
+/**
+ * @brief Hashes a string the same way Unreal hashes string map keys (`FCrc::Strihash_DEPRECATED`).
+ * @note Only uppercases ascii, which is all our keys ever use.
+ * @note Only checked against Unreal's source, not against the buckets of a game-built object.
+ *
+ * @param str The string to hash.
+ * @return The hash.
+ */
+constexpr uint32_t strihash(std::wstring_view str) {
+    const constexpr uint32_t BYTE_MASK = 0xFF;
+    const constexpr auto BITS_PER_BYTE = 8;
+
+    uint32_t hash = 0;
+    for (auto chr : str) {
+        if (L'a' <= chr && chr <= L'z') {
+            chr = (wchar_t)(chr - L'a' + L'A');
+        }
+        // Hashes both bytes of each (UTF-16) character, low first
+        for (auto shift : {0, BITS_PER_BYTE}) {
+            auto byte = ((uint32_t)chr >> shift) & BYTE_MASK;
+            hash = (hash >> BITS_PER_BYTE) ^ STRIHASH_CRC_TABLE[(hash ^ byte) & BYTE_MASK];
+        }
+    }
+    return hash;
+}
+
 template <typename K, typename V>
 struct KeyValuePair {
     K key;
     V value;
+    /// The index of the next entry in the same hash bucket, or -1.
     int32_t hash_next_id;
+    /// The index of the hash bucket this entry is in.
     int32_t hash_idx;
 };
 
 using JSONObjectEntry = KeyValuePair<FString, TSharedPtr<FJsonValue>>;
 
+/**
+ * @brief A json object, which is really a `TMap<FString, TSharedPtr<FJsonValue>>`.
+ * @note The entries array, allocation flags, and free list make up the map's sparse array, the
+ *       rest is it's hash.
+ */
 struct FJsonObject {
-    static const constexpr auto PATTERN_SIZE = 16;
-
     TArray<JSONObjectEntry> entries;
+    /// Which entries are in use, rather than part of the free list.
+    TBitArray allocation_flags;
+    int32_t first_free_idx;
+    int32_t num_free_indices;
+    /// The index of the first entry in each hash bucket, or -1 if empty.
+    TInlineAllocation<int32_t, 1> hash;
+    /// The number of hash buckets, always a power of two.
+    int32_t hash_size;
+
+    /**
+     * @brief Looks up a value on this object given it's key, without allocating.
+     *
+     * @tparam n The size of the key literal.
+     * @param key The key to look up.
+     * @return A pointer to the value object, or nullptr if the key is not found.
+     */
+    template <size_t n>
+    [[nodiscard]] FJsonValue* find_value(const wchar_t (&key)[n]) const {
+        auto value = this->find_hashed_value(key);
+        if (value != nullptr) {
+            return value;
+        }
+
+        // The hash is only reverse engineered, so double check misses rather than risk missing
+        //  keys which are actually there - they're rare, most lookups are of required keys
+        for (uint32_t i = 0; i < this->entries.count; i++) {
+            if (this->allocation_flags.is_set(i) && this->entries.data[i].key.equals(key)) {
+                return this->entries.data[i].value.obj;
+            }
+        }
+        return nullptr;
+    }
 
-    // Unknown what this data represents.
-    uint32_t pattern[PATTERN_SIZE];
+    /**
+     * @brief Looks up a value on this object by walking it's hash, without allocating.
+     * @note Gives up if the hash doesn't look valid, rather than risk reading out of bounds.
+     *
+     * @tparam n The size of the key literal.
+     * @param key The key to look up.
+     * @return A pointer to the value object, or nullptr if the key is not found.
+     */
+    template <size_t n>
+    [[nodiscard]] FJsonValue* find_hashed_value(const wchar_t (&key)[n]) const {
+        if (this->hash_size <= 0 || !std::has_single_bit((uint32_t)this->hash_size)
+            || (this->hash_size > 1 && this->hash.secondary_data == nullptr)) {
+            return nullptr;
+        }
+        // With a single bucket every entry is in it, no need to hash the key
+        uint32_t bucket = 0;
+        if (this->hash_size > 1) {
+            bucket = strihash({&key[0], n - 1}) & (uint32_t)(this->hash_size - 1);
+        }
+
+        // A valid chain never visits an entry twice, so can't be longer than the amount of entries
+        auto idx = this->hash.get()[bucket];
+        for (uint32_t steps = 0; idx != -1; steps++) {
+            if (steps >= this->entries.count || idx < 0 || (uint32_t)idx >= this->entries.count
+                || !this->allocation_flags.is_set((uint32_t)idx)) {
+                return nullptr;
+            }
+
+            const auto& entry = this->entries.data[idx];
+            if (entry.key.equals(key)) {
+                return entry.value.obj;
+            }
+            idx = entry.hash_next_id;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Looks up a value on this object given it's key, without allocating or throwing.
+     *
+     * @tparam T The type to cast the value to.
+     * @tparam n The size of the key literal.
+     * @param key The key to look up.
+     * @return A pointer to the value object, or nullptr if the key is not found, or if the value is
+     *         of the wrong type.
+     */
+    template <typename T, size_t n>
+    [[nodiscard]] T* find(const wchar_t (&key)[n]) const {
+        FJsonValue* value = this->find_value(key);
+        return value == nullptr ? nullptr : value->try_cast<T>();
+    }
 
     /**
      * @brief Gets a value on this object given it's key.
-     * @note Throws a runtime error if the key is not found.
+     * @note Throws a runtime error if the key is not found, or if the value is of the wrong type.
      *
      * @tparam T The type to cast the value to.
+     * @tparam n The size of the key literal.
      * @param key The key to look up.
      * @return A pointer to the value object.
      */
-    template <typename T>
-    T* get(const std::wstring& key) const;
+    template <typename T, size_t n>
+    T* get(const wchar_t (&key)[n]) const {
+        FJsonValue* value = this->find_value(key);
+        if (value == nullptr) {
+            throw std::runtime_error("Couldn't find key!");
+        }
+        return value->cast<T>();
+    }
 };
 
 struct FJsonValueString : FJsonValue {
@@ -98,6 +332,18 @@ struct FJsonValueString : FJsonValue {
      * @return An stl string.
      */
     [[nodiscard]] std::wstring to_wstr(void) const;
+
+    /**
+     * @brief Checks if this string is equal to a wide string literal, without allocating.
+     *
+     * @tparam n The size of the literal, including it's null terminator.
+     * @param literal The literal to compare against.
+     * @return True if the strings are equal.
+     */
+    template <size_t n>
+    [[nodiscard]] bool equals(const wchar_t (&literal)[n]) const {
+        return this->str.equals(literal);
+    }
 };
 
 struct FJsonValueArray : FJsonValue {
@@ -120,6 +366,17 @@ struct FJsonValueArray : FJsonValue {
      */
     template <typename T>
     T* get(uint32_t idx) const;
+
+    /**
+     * @brief Gets an entry in the array given it's index, without throwing.
+     *
+     * @tparam T The type to cast the value to.
+     * @param idx The index to get.
+     * @return A pointer to the value object, or nullptr if the index is out of range, or if the
+     *         value is of the wrong type.
+     */
+    template <typename T>
+    [[nodiscard]] T* find(uint32_t idx) const;
 };
 
 struct FJsonValueObject : FJsonValue {
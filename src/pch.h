@@ -7,6 +7,8 @@
 
 #include <TlHelp32.h>
 
+#include <immintrin.h>
+
 #include <d3d11.h>
 #include <d3d12.h>
 #include <dxgi1_4.h>
@@ -16,6 +18,10 @@
 #include <archive.h>
 #include <archive_entry.h>
 
+#include <zlib.h>
+
+#include <zstd.h>
+
 #ifdef __cplusplus
 
 #define IMGUI_DEFINE_MATH_OPERATORS
@@ -34,21 +40,38 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND h_wnd,
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
 #include <chrono>
 #include <cinttypes>
+#include <compare>
 #include <cstdint>
+#include <cstdlib>
 #include <exception>
 #include <filesystem>
 #include <format>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
 #include <ratio>
 #include <sstream>
+#include <stop_token>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 using std::int16_t;